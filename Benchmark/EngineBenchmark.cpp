@@ -0,0 +1,215 @@
+#include "EngineBenchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace EngineBenchmark
+{
+    namespace
+    {
+        constexpr float threshold = -24.0f;
+        constexpr float ratio = 4.0f;
+        constexpr float attackTime = 0.01f;
+        constexpr float releaseTime = 0.05f;
+        constexpr double toggleSeconds = 0.01;
+
+        // Each channel gets its own phase and noise, so linked detection has work to do
+        void fillInput(juce::AudioBuffer<float>& input, InputState state, double sampleRate)
+        {
+            input.clear();
+            if (state == InputState::silence)
+                return;
+
+            std::mt19937 random(1234);
+            std::uniform_real_distribution<float> noise(-0.1f, 0.1f);
+            const auto frequency = state == InputState::toggling ? 1000.0 : 440.0;
+            const auto amplitude = state == InputState::belowThreshold ? juce::Decibels::decibelsToGain(-44.0f) : 0.9f;
+            const auto toggleSamples = juce::jmax(1, juce::roundToInt(toggleSeconds * sampleRate));
+
+            for (int channel = 0; channel < input.getNumChannels(); ++channel)
+            {
+                auto* samples = input.getWritePointer(channel);
+                const auto phase = 0.7 * channel;
+
+                for (int sample = 0; sample < input.getNumSamples(); ++sample)
+                {
+                    auto value = amplitude * static_cast<float>(std::sin(2.0 * juce::MathConstants<double>::pi * frequency * sample / sampleRate + phase));
+
+                    if (state == InputState::heavyCompression)
+                        value += noise(random);
+                    else if (state == InputState::toggling && (sample / toggleSamples) % 2 == 1)
+                        value *= 0.001f;
+
+                    samples[sample] = value;
+                }
+            }
+        }
+
+        void setUp(Compressor<float>& compressor, const Case& benchmarkCase)
+        {
+            compressor.setThreshold(threshold);
+            compressor.setRatio(ratio);
+            compressor.setKnee(benchmarkCase.knee);
+            compressor.setAttackTime(attackTime);
+            compressor.setReleaseTime(releaseTime);
+            compressor.setAttackWavetable(CurvePresets::make(benchmarkCase.shape, false));
+            compressor.setReleaseWavetable(CurvePresets::make(benchmarkCase.shape, true));
+            compressor.prepare(benchmarkCase.sampleRate, benchmarkCase.blockSize, benchmarkCase.numChannels, benchmarkCase.numChannels);
+        }
+
+        // Nanoseconds spent in process() over the whole input
+        double timeRun(Compressor<float>& compressor, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& block)
+        {
+            const auto blockSize = block.getNumSamples();
+            juce::int64 ticks = 0;
+
+            for (int position = 0; position + blockSize <= input.getNumSamples(); position += blockSize)
+            {
+                for (int channel = 0; channel < block.getNumChannels(); ++channel)
+                    block.copyFrom(channel, 0, input, channel, position, blockSize);
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                compressor.process(block);
+                ticks += juce::Time::getHighResolutionTicks() - start;
+            }
+
+            return 1.0e9 * static_cast<double>(ticks) / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        }
+    }
+
+    const char* getName(InputState state)
+    {
+        switch (state)
+        {
+            case InputState::silence:          return "silence";
+            case InputState::belowThreshold:   return "below_threshold";
+            case InputState::heavyCompression: return "heavy_compression";
+            case InputState::toggling:         return "toggling";
+        }
+
+        return "";
+    }
+
+    const std::vector<int>& getBlockSizes()
+    {
+        static const std::vector<int> values { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        return values;
+    }
+
+    const std::vector<int>& getChannelCounts()
+    {
+        static const std::vector<int> values { 1, 2, 8, 16 };
+        return values;
+    }
+
+    const std::vector<double>& getSampleRates()
+    {
+        static const std::vector<double> values { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0, 384000.0 };
+        return values;
+    }
+
+    const std::vector<float>& getKnees()
+    {
+        static const std::vector<float> values { 0.0f, 6.0f, 24.0f };
+        return values;
+    }
+
+    std::vector<Case> makeCases(bool full)
+    {
+        std::vector<Case> cases;
+
+        for (int stateIndex = 0; stateIndex < numInputStates; ++stateIndex)
+        {
+            Case base;
+            base.state = static_cast<InputState>(stateIndex);
+
+            if (full)
+            {
+                for (auto blockSize : getBlockSizes())
+                    for (auto numChannels : getChannelCounts())
+                        for (auto sampleRate : getSampleRates())
+                            for (auto knee : getKnees())
+                                for (int shape = 0; shape < CurvePresets::numShapes; ++shape)
+                                    cases.push_back({ base.state, blockSize, numChannels, sampleRate, knee, static_cast<CurvePresets::Shape>(shape) });
+
+                continue;
+            }
+
+            // The defaults themselves are covered once, by the block size sweep
+            for (auto blockSize : getBlockSizes())
+            {
+                auto variant = base;
+                variant.blockSize = blockSize;
+                cases.push_back(variant);
+            }
+
+            for (auto numChannels : getChannelCounts())
+            {
+                auto variant = base;
+                variant.numChannels = numChannels;
+                if (numChannels != base.numChannels)
+                    cases.push_back(variant);
+            }
+
+            for (auto sampleRate : getSampleRates())
+            {
+                auto variant = base;
+                variant.sampleRate = sampleRate;
+                if (sampleRate != base.sampleRate)
+                    cases.push_back(variant);
+            }
+
+            for (auto knee : getKnees())
+            {
+                auto variant = base;
+                variant.knee = knee;
+                if (knee != base.knee)
+                    cases.push_back(variant);
+            }
+
+            for (int shape = 0; shape < CurvePresets::numShapes; ++shape)
+            {
+                auto variant = base;
+                variant.shape = static_cast<CurvePresets::Shape>(shape);
+                if (variant.shape != base.shape)
+                    cases.push_back(variant);
+            }
+        }
+
+        return cases;
+    }
+
+    Result measure(const Case& benchmarkCase, double seconds, int numRuns)
+    {
+        // Whole blocks only, so every process() call is a full block
+        const auto numBlocks = juce::jmax(1, juce::roundToInt(seconds * benchmarkCase.sampleRate / benchmarkCase.blockSize));
+        juce::AudioBuffer<float> input(benchmarkCase.numChannels, numBlocks * benchmarkCase.blockSize);
+        juce::AudioBuffer<float> block(benchmarkCase.numChannels, benchmarkCase.blockSize);
+        fillInput(input, benchmarkCase.state, benchmarkCase.sampleRate);
+
+        // As a host runs the plugin; otherwise denormal gain reduction tails
+        // dominate the toggling cases at high sample rates
+        const juce::ScopedNoDenormals noDenormals;
+
+        Compressor<float> compressor;
+        setUp(compressor, benchmarkCase);
+
+        // The first run warms caches and settles the envelope; the rest carry
+        // on from its state, as a long render would
+        timeRun(compressor, input, block);
+
+        std::vector<double> nsPerSample;
+        const auto numSamples = static_cast<double>(input.getNumSamples()) * benchmarkCase.numChannels;
+
+        for (int run = 0; run < juce::jmax(1, numRuns); ++run)
+            nsPerSample.push_back(timeRun(compressor, input, block) / numSamples);
+
+        std::sort(nsPerSample.begin(), nsPerSample.end());
+
+        Result result;
+        result.numRuns = static_cast<int>(nsPerSample.size());
+        result.nsPerSample = nsPerSample[nsPerSample.size() / 2];
+        result.minNsPerSample = nsPerSample.front();
+        return result;
+    }
+}
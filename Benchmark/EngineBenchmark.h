@@ -0,0 +1,66 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "Compressor.h"
+#include "CurvePresets.h"
+#include <vector>
+
+//==============================================================================
+// Times Compressor<float>::process() on synthetic input, in nanoseconds per
+// sample (per channel), for one configuration at a time.
+//
+// Every case uses the same settings apart from what it varies: threshold
+// -24 dB, ratio 4:1, 10 ms attack, 50 ms release, peak detector, per-sample
+// envelope, no oversampling or lookahead. The input is generated before
+// timing starts and copied into the block buffer outside the timed region,
+// so only process() is measured. Denormals are flushed to zero, as hosts do.
+namespace EngineBenchmark
+{
+    enum class InputState
+    {
+        silence,          // digital zero
+        belowThreshold,   // a -44 dBFS sine, which keeps the compressor at rest
+        heavyCompression, // a full-scale sine with noise, about 18 dB of gain reduction
+        toggling          // a sine gated between 0 and -60 dBFS every 10 ms, so the envelope never settles
+    };
+
+    inline constexpr int numInputStates = 4;
+
+    const char* getName(InputState state);
+
+    struct Case
+    {
+        InputState state = InputState::heavyCompression;
+        int blockSize = 512;
+        int numChannels = 2;
+        double sampleRate = 48000.0;
+        float knee = 6.0f;
+        CurvePresets::Shape shape = CurvePresets::Shape::linear;
+    };
+
+    struct Result
+    {
+        double nsPerSample = 0.0;    // median over the runs
+        double minNsPerSample = 0.0; // fastest run
+        int numRuns = 0;
+
+        // Audio processed per second of CPU time on one core, per channel count
+        double getRealtimeMultiple(const Case& benchmarkCase) const
+        {
+            return nsPerSample > 0.0 ? 1.0e9 / (nsPerSample * benchmarkCase.sampleRate * benchmarkCase.numChannels) : 0.0;
+        }
+    };
+
+    // Values swept by each axis
+    const std::vector<int>& getBlockSizes();      // 16 .. 4096
+    const std::vector<int>& getChannelCounts();   // 1, 2, 8, 16
+    const std::vector<double>& getSampleRates();  // 44.1 .. 384 kHz
+    const std::vector<float>& getKnees();         // hard, 6 dB, 24 dB
+
+    // Every input state against each axis in turn, the others at the Case
+    // defaults. With full, the whole cross product instead (several thousand cases)
+    std::vector<Case> makeCases(bool full);
+
+    // Warms up once, then times numRuns runs of seconds of audio each
+    Result measure(const Case& benchmarkCase, double seconds, int numRuns);
+}
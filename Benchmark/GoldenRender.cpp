@@ -0,0 +1,519 @@
+#include "GoldenRender.h"
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace GoldenRender
+{
+    namespace
+    {
+        constexpr auto twoPi = juce::MathConstants<double>::twoPi;
+
+        // xorshift32: the same noise on every standard library
+        struct Noise
+        {
+            uint32_t state = 0x9e3779b9u;
+
+            float next()
+            {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                return static_cast<float>(state) * (2.0f / 4294967296.0f) - 1.0f;
+            }
+        };
+
+        int secondsToSamples(double seconds, double rate)
+        {
+            return static_cast<int>(seconds * rate);
+        }
+
+        void makeSweep(juce::AudioBuffer<float>& audio, double rate)
+        {
+            const auto numSamples = audio.getNumSamples();
+            const auto duration = numSamples / rate;
+            const auto logRange = std::log(20000.0 / 20.0);
+            double phase = 0.0;
+
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                const auto time = sample / rate;
+                const auto frequency = 20.0 * std::exp(logRange * time / duration);
+                const auto levelDb = -40.0 + 40.0 * time / duration;
+                const auto value = juce::Decibels::decibelsToGain(levelDb) * std::sin(phase);
+
+                audio.setSample(0, sample, static_cast<float>(value));
+                audio.setSample(1, sample, static_cast<float>(0.5 * value));
+                phase = std::fmod(phase + twoPi * frequency / rate, twoPi);
+            }
+        }
+
+        void makeBursts(juce::AudioBuffer<float>& audio, double rate)
+        {
+            static constexpr double levelsDb[] { -30.0, -12.0, 0.0, -6.0 };
+            const auto period = secondsToSamples(0.2, rate);
+            const auto burstLength = secondsToSamples(0.05, rate);
+            const auto rightOffset = secondsToSamples(0.025, rate);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                for (int sample = 0; sample < audio.getNumSamples(); ++sample)
+                {
+                    const auto position = sample - channel * rightOffset;
+                    if (position < 0 || position % period >= burstLength)
+                        continue;
+
+                    const auto level = juce::Decibels::decibelsToGain(levelsDb[(position / period) % 4]);
+                    audio.setSample(channel, sample, static_cast<float>(level * std::sin(twoPi * 1000.0 * position / rate)));
+                }
+            }
+        }
+
+        void makeDrumLoop(juce::AudioBuffer<float>& audio, double rate)
+        {
+            // Sixteenth notes at 120 bpm; k = kick, s = snare, h = hat
+            static constexpr const char* pattern = "k.h.s.hkk.h.s.hh";
+            const auto step = secondsToSamples(0.125, rate);
+            Noise noise;
+
+            for (int index = 0; pattern[index] != 0; ++index)
+            {
+                const auto hit = pattern[index];
+                const auto start = index * step;
+
+                for (int offset = 0; start + offset < audio.getNumSamples() && offset < 2 * step; ++offset)
+                {
+                    const auto time = offset / rate;
+                    float left = 0.0f, right = 0.0f;
+
+                    if (hit == 'k')
+                    {
+                        // Pitch falling from 150 to 50 Hz
+                        const auto phase = twoPi * (50.0 * time + 100.0 * 0.03 * (1.0 - std::exp(-time / 0.03)));
+                        left = right = static_cast<float>(0.9 * std::exp(-time / 0.15) * std::sin(phase));
+                    }
+                    else if (hit == 's')
+                    {
+                        const auto body = 0.4 * std::exp(-time / 0.1) * std::sin(twoPi * 180.0 * time);
+                        left = right = static_cast<float>(body + 0.5 * std::exp(-time / 0.08) * noise.next());
+                    }
+                    else if (hit == 'h')
+                    {
+                        const auto value = static_cast<float>(0.25 * std::exp(-time / 0.02)) * noise.next();
+                        left = 0.6f * value;
+                        right = value;
+                    }
+
+                    audio.addSample(0, start + offset, left);
+                    audio.addSample(1, start + offset, right);
+                }
+            }
+        }
+
+        // Settings every render shares
+        void setUpCurves(Compressor<float>& compressor, CurvePresets::Shape shape)
+        {
+            compressor.setThreshold(-20.0f);
+            compressor.setRatio(4.0f);
+            compressor.setKnee(6.0f);
+            compressor.setAttackWavetable(CurvePresets::make(shape, false));
+            compressor.setReleaseWavetable(CurvePresets::make(shape, true));
+        }
+
+        void setUp(Compressor<float>& compressor, const Case& goldenCase)
+        {
+            using Detector = Compressor<float>::DetectorMode;
+            using Envelope = Compressor<float>::EnvelopeMode;
+
+            setUpCurves(compressor, goldenCase.shape);
+            compressor.setAttackTime(0.01f);
+            compressor.setReleaseTime(0.1f);
+
+            switch (goldenCase.config)
+            {
+                case Config::peak:
+                    compressor.setDetectorMode(Detector::peak);
+                    compressor.setEnvelopeMode(Envelope::perSample);
+                    break;
+
+                case Config::rmsEco:
+                    compressor.setDetectorMode(Detector::rms);
+                    compressor.setEnvelopeMode(Envelope::eco);
+                    break;
+
+                case Config::hybridLookahead:
+                    compressor.setDetectorMode(Detector::hybrid);
+                    compressor.setEnvelopeMode(Envelope::perSample);
+                    compressor.setOversamplingFactor(1);
+                    compressor.setLookahead(2.0f);
+                    break;
+            }
+
+            compressor.prepare(sampleRate, blockSize, numChannels, numChannels);
+        }
+
+        void process(Compressor<float>& compressor, juce::AudioBuffer<float>& audio)
+        {
+            for (int position = 0; position < audio.getNumSamples(); position += blockSize)
+            {
+                const auto numSamples = juce::jmin(blockSize, audio.getNumSamples() - position);
+                compressor.process(juce::dsp::AudioBlock<float>(audio).getSubBlock(static_cast<size_t>(position), static_cast<size_t>(numSamples)));
+            }
+        }
+
+        struct EcoSettings
+        {
+            double rate;
+            int attackMs, releaseMs;
+            CurvePresets::Shape shape;
+        };
+
+        juce::AudioBuffer<float> renderEco(const juce::AudioBuffer<float>& input, const EcoSettings& settings, Compressor<float>::EnvelopeMode envelope)
+        {
+            juce::AudioBuffer<float> audio;
+            audio.makeCopyOf(input);
+
+            Compressor<float> compressor;
+            setUpCurves(compressor, settings.shape);
+            compressor.setAttackTime(static_cast<float>(settings.attackMs) * 0.001f);
+            compressor.setReleaseTime(static_cast<float>(settings.releaseMs) * 0.001f);
+            compressor.setDetectorMode(Compressor<float>::DetectorMode::rms);
+            compressor.setEnvelopeMode(envelope);
+            compressor.prepare(settings.rate, blockSize, numChannels, numChannels);
+            process(compressor, audio);
+            return audio;
+        }
+
+        // Both renders have the same input, so the ratio of the outputs is the
+        // ratio of the gains. Samples below -60 dBFS are left out
+        void compareGains(const juce::AudioBuffer<float>& input, const juce::AudioBuffer<float>& perSample,
+                          const juce::AudioBuffer<float>& eco, EcoReport& report)
+        {
+            const auto minLevel = juce::Decibels::decibelsToGain(-60.0f);
+            double sumOfSquares = 0.0;
+            int numCompared = 0;
+
+            for (int channel = 0; channel < input.getNumChannels(); ++channel)
+            {
+                for (int sample = 0; sample < input.getNumSamples(); ++sample)
+                {
+                    if (std::abs(input.getSample(channel, sample)) < minLevel)
+                        continue;
+
+                    const auto errorDb = 20.0 * std::log10(std::abs(static_cast<double>(eco.getSample(channel, sample))
+                                                                    / static_cast<double>(perSample.getSample(channel, sample))));
+                    report.maxErrorDb = juce::jmax(report.maxErrorDb, static_cast<float>(std::abs(errorDb)));
+                    sumOfSquares += errorDb * errorDb;
+                    ++numCompared;
+                }
+            }
+
+            if (numCompared > 0)
+                report.rmsErrorDb = static_cast<float>(std::sqrt(sumOfSquares / numCompared));
+        }
+
+        juce::File getHashFile(const juce::File& folder)                          { return folder.getChildFile("golden.json"); }
+        juce::File getAudioFile(const juce::File& folder, const juce::String& name) { return folder.getChildFile(name + ".f32"); }
+
+        // Reference audio covers the start of a render: reads as many samples
+        // as the file holds, up to maxSamples per channel
+        bool loadAudio(const juce::File& file, int maxSamples, juce::AudioBuffer<float>& audio)
+        {
+            juce::MemoryBlock data;
+            const auto bytesPerFrame = static_cast<size_t>(numChannels) * sizeof(float);
+
+            if (! file.loadFileAsData(data) || data.getSize() == 0 || data.getSize() % bytesPerFrame != 0
+                || data.getSize() / bytesPerFrame > static_cast<size_t>(maxSamples))
+                return false;
+
+            const auto bytesPerChannel = data.getSize() / static_cast<size_t>(numChannels);
+            audio.setSize(numChannels, static_cast<int>(bytesPerChannel / sizeof(float)));
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                data.copyTo(audio.getWritePointer(channel), static_cast<int>(bytesPerChannel * static_cast<size_t>(channel)), bytesPerChannel);
+
+            return true;
+        }
+
+        bool saveAudio(const juce::File& file, const juce::AudioBuffer<float>& audio, int numSamples)
+        {
+            juce::MemoryBlock data;
+            for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+                data.append(audio.getReadPointer(channel), static_cast<size_t>(numSamples) * sizeof(float));
+
+            return file.replaceWithData(data.getData(), data.getSize());
+        }
+    }
+
+    const char* getName(Signal signal)
+    {
+        switch (signal)
+        {
+            case Signal::sweep:    return "sweep";
+            case Signal::bursts:   return "bursts";
+            case Signal::drumLoop: return "drum_loop";
+        }
+
+        return "";
+    }
+
+    const char* getName(Config config)
+    {
+        switch (config)
+        {
+            case Config::peak:            return "peak";
+            case Config::rmsEco:          return "rms_eco";
+            case Config::hybridLookahead: return "hybrid_lookahead";
+        }
+
+        return "";
+    }
+
+    juce::String Case::getName() const
+    {
+        return juce::String(GoldenRender::getName(signal)) + "_" + GoldenRender::getName(config) + "_"
+             + juce::String(CurvePresets::getName(shape)).replaceCharacter('-', '_');
+    }
+
+    bool hasReferenceAudio(const Case& goldenCase)
+    {
+        return goldenCase.signal == Signal::drumLoop && goldenCase.shape == CurvePresets::Shape::linear;
+    }
+
+    std::vector<Case> makeCases()
+    {
+        std::vector<Case> cases;
+
+        for (int signal = 0; signal < numSignals; ++signal)
+            for (int config = 0; config < numConfigs; ++config)
+                for (int shape = 0; shape < CurvePresets::numShapes; ++shape)
+                    cases.push_back({ static_cast<Signal>(signal), static_cast<Config>(config), static_cast<CurvePresets::Shape>(shape) });
+
+        return cases;
+    }
+
+    juce::AudioBuffer<float> makeSignal(Signal signal, double rate)
+    {
+        juce::AudioBuffer<float> audio(numChannels, secondsToSamples(signal == Signal::bursts ? 1.6 : 2.0, rate));
+        audio.clear();
+
+        switch (signal)
+        {
+            case Signal::sweep:    makeSweep(audio, rate); break;
+            case Signal::bursts:   makeBursts(audio, rate); break;
+            case Signal::drumLoop: makeDrumLoop(audio, rate); break;
+        }
+
+        return audio;
+    }
+
+    juce::AudioBuffer<float> render(const Case& goldenCase)
+    {
+        const juce::ScopedNoDenormals noDenormals;
+
+        auto audio = makeSignal(goldenCase.signal);
+        Compressor<float> compressor;
+        setUp(compressor, goldenCase);
+        process(compressor, audio);
+        return audio;
+    }
+
+    juce::String hash(const juce::AudioBuffer<float>& audio)
+    {
+        uint64_t value = 0xcbf29ce484222325ull;
+
+        for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+        {
+            const auto* samples = audio.getReadPointer(channel);
+            for (int sample = 0; sample < audio.getNumSamples(); ++sample)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, samples + sample, sizeof(bits));
+
+                for (int byte = 0; byte < 4; ++byte)
+                {
+                    value ^= (bits >> (8 * byte)) & 0xffu;
+                    value *= 0x100000001b3ull;
+                }
+            }
+        }
+
+        return juce::String::toHexString(static_cast<juce::int64>(value)).paddedLeft('0', 16);
+    }
+
+    juce::Result record(const juce::File& folder, bool withAudio)
+    {
+        if (! folder.createDirectory())
+            return juce::Result::fail("Cannot create " + folder.getFullPathName());
+
+        auto* hashes = new juce::DynamicObject();
+        juce::var hashesVar(hashes);
+
+        for (const auto& goldenCase : makeCases())
+        {
+            const auto audio = render(goldenCase);
+            hashes->setProperty(goldenCase.getName(), hash(audio));
+
+            if (! withAudio || ! hasReferenceAudio(goldenCase))
+                continue;
+
+            const auto referenceLength = juce::jmin(audio.getNumSamples(), secondsToSamples(referenceSeconds, sampleRate));
+            if (! saveAudio(getAudioFile(folder, goldenCase.getName()), audio, referenceLength))
+                return juce::Result::fail("Cannot write " + getAudioFile(folder, goldenCase.getName()).getFullPathName());
+        }
+
+        auto* golden = new juce::DynamicObject();
+        juce::var goldenVar(golden);
+        golden->setProperty("sample_rate", sampleRate);
+        golden->setProperty("block_size", blockSize);
+        golden->setProperty("hashes", hashesVar);
+
+        if (! getHashFile(folder).replaceWithText(juce::JSON::toString(goldenVar)))
+            return juce::Result::fail("Cannot write " + getHashFile(folder).getFullPathName());
+
+        return juce::Result::ok();
+    }
+
+    juce::Result check(const juce::File& folder, float toleranceDb, std::vector<CaseReport>& reports)
+    {
+        juce::var golden;
+        if (const auto result = juce::JSON::parse(getHashFile(folder).loadFileAsString(), golden); result.failed())
+            return juce::Result::fail("Cannot read " + getHashFile(folder).getFullPathName() + ": " + result.getErrorMessage());
+
+        if (static_cast<double>(golden["sample_rate"]) != sampleRate || static_cast<int>(golden["block_size"]) != blockSize)
+            return juce::Result::fail(getHashFile(folder).getFullPathName() + " was recorded with different render settings");
+
+        const auto hashes = golden["hashes"];
+        const auto tolerance = juce::Decibels::decibelsToGain(toleranceDb, -200.0f);
+        reports.clear();
+
+        for (const auto& goldenCase : makeCases())
+        {
+            CaseReport report;
+            report.name = goldenCase.getName();
+
+            const auto expectedHash = hashes[juce::Identifier(report.name)].toString();
+            const auto audio = render(goldenCase);
+
+            if (expectedHash.isEmpty())
+            {
+                report.detail = "no golden hash";
+            }
+            else if (hash(audio) == expectedHash)
+            {
+                report.status = CaseReport::Status::bitExact;
+            }
+            else
+            {
+                juce::AudioBuffer<float> reference;
+                if (! loadAudio(getAudioFile(folder, report.name), audio.getNumSamples(), reference))
+                {
+                    report.status = CaseReport::Status::failed;
+                    report.detail = "hash differs and there is no reference audio to null against";
+                }
+                else
+                {
+                    float maxDifference = 0.0f;
+                    for (int channel = 0; channel < reference.getNumChannels(); ++channel)
+                        for (int sample = 0; sample < reference.getNumSamples(); ++sample)
+                            maxDifference = juce::jmax(maxDifference, std::abs(audio.getSample(channel, sample) - reference.getSample(channel, sample)));
+
+                    report.maxDifferenceDb = juce::Decibels::gainToDecibels(maxDifference, -200.0f);
+                    report.status = maxDifference <= tolerance ? CaseReport::Status::withinTolerance : CaseReport::Status::failed;
+
+                    if (report.status == CaseReport::Status::failed)
+                        report.detail = "nulls to " + juce::String(report.maxDifferenceDb, 1) + " dBFS";
+                }
+            }
+
+            reports.push_back(report);
+        }
+
+        return juce::Result::ok();
+    }
+
+    std::vector<EcoReport> checkEco()
+    {
+        using Envelope = Compressor<float>::EnvelopeMode;
+
+        static constexpr double rates[] { 44100.0, 96000.0, 192000.0 };
+        static constexpr int attackReleaseMs[][2] { { 1, 10 }, { 10, 100 }, { 100, 1000 } };
+
+        const juce::ScopedNoDenormals noDenormals;
+        std::vector<EcoReport> reports;
+
+        for (int signal = 0; signal < numSignals; ++signal)
+        {
+            for (const auto rate : rates)
+            {
+                const auto input = makeSignal(static_cast<Signal>(signal), rate);
+
+                for (const auto& times : attackReleaseMs)
+                {
+                    for (int shape = 0; shape < CurvePresets::numShapes; ++shape)
+                    {
+                        const EcoSettings settings { rate, times[0], times[1], static_cast<CurvePresets::Shape>(shape) };
+
+                        EcoReport report;
+                        report.name << getName(static_cast<Signal>(signal)) << "_rms_" << juce::roundToInt(rate / 1000.0) << "k_"
+                                    << times[0] << "ms_" << times[1] << "ms_"
+                                    << juce::String(CurvePresets::getName(settings.shape)).replaceCharacter('-', '_');
+
+                        compareGains(input, renderEco(input, settings, Envelope::perSample), renderEco(input, settings, Envelope::eco), report);
+                        reports.push_back(report);
+                    }
+                }
+            }
+        }
+
+        return reports;
+    }
+
+    juce::Result checkKeyOversampling()
+    {
+        static constexpr int factorsLog2[] { 0, 1, 0, 2, 1, 2 };
+        static constexpr int blocksPerFactor = 8;
+
+        const juce::ScopedNoDenormals noDenormals;
+        const auto bursts = makeSignal(Signal::bursts);
+        const auto numSamples = bursts.getNumSamples();
+
+        juce::AudioBuffer<float> key(1, numSamples);
+        key.copyFrom(0, 0, bursts, 0, 0, numSamples);
+
+        juce::AudioBuffer<float> audio(numChannels, numSamples);
+        for (int channel = 0; channel < numChannels; ++channel)
+            audio.copyFrom(channel, 0, bursts, 0, 0, numSamples);
+
+        Compressor<float> compressor;
+        setUpCurves(compressor, CurvePresets::Shape::linear);
+        compressor.prepare(sampleRate, blockSize, numChannels, numChannels);
+
+        const int unlinked[] { 0, 1 };
+        compressor.setLinkGroups(unlinked, numChannels);
+
+        for (int position = 0, block = 0; position < numSamples; position += blockSize, ++block)
+        {
+            const auto start = static_cast<size_t>(position);
+            const auto length = static_cast<size_t>(juce::jmin(blockSize, numSamples - position));
+
+            compressor.setOversamplingFactor(factorsLog2[(block / blocksPerFactor) % std::size(factorsLog2)]);
+            compressor.process(juce::dsp::AudioBlock<float>(audio).getSubBlock(start, length),
+                               juce::dsp::AudioBlock<const float>(key).getSubBlock(start, length));
+        }
+
+        bool compressed = false;
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            if (audio.getSample(0, sample) != audio.getSample(1, sample))
+                return juce::Result::fail("channels keyed by the same mono key differ from sample " + juce::String(sample));
+
+            compressed = compressed || audio.getSample(0, sample) != bursts.getSample(0, sample);
+        }
+
+        if (! compressed)
+            return juce::Result::fail("the mono key never compressed the audio");
+
+        return juce::Result::ok();
+    }
+}
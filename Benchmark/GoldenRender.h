@@ -0,0 +1,127 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "Compressor.h"
+#include "CurvePresets.h"
+#include <vector>
+
+//==============================================================================
+// Golden renders: fixed test signals, synthesized here, rendered through the
+// Compressor with every preset curve shape under a few engine configurations,
+// and compared against a stored set.
+//
+// A golden folder holds golden.json, the hash of every case's output, and for
+// the cases hasReferenceAudio() picks, <case>.f32 with the first
+// referenceSeconds of the output (raw native-endian float, one channel after
+// the other). A case passes if its hash matches; otherwise, if it has
+// reference audio, if that stretch nulls against it within a tolerance.
+//
+// The goldens live in Benchmark/Golden and CTest runs the check against them.
+// They are recorded with SONDYCOMP_EXACT_MATH off and floating-point
+// contraction off in every target (see CMakeLists.txt): with fused
+// multiply-adds, last-bit differences decide whether the envelope attacks or
+// releases on near-equal levels, and renders drift far beyond any tolerance.
+namespace GoldenRender
+{
+    inline constexpr double sampleRate = 48000.0;
+    inline constexpr int numChannels = 2;
+    inline constexpr int blockSize = 512;
+    inline constexpr double referenceSeconds = 0.5;
+
+    enum class Signal
+    {
+        sweep,    // 20 Hz - 20 kHz log sweep rising from -40 to 0 dBFS
+        bursts,   // 1 kHz tone bursts stepping through -30, -12, 0 and -6 dBFS
+        drumLoop  // one bar of kick, snare and hi-hat at 120 bpm
+    };
+
+    inline constexpr int numSignals = 3;
+
+    enum class Config
+    {
+        peak,            // peak detector, per-sample envelope
+        rmsEco,          // RMS detector, eco envelope
+        hybridLookahead  // hybrid detector, 2x oversampling, 2 ms lookahead
+    };
+
+    inline constexpr int numConfigs = 3;
+
+    const char* getName(Signal signal);
+    const char* getName(Config config);
+
+    struct Case
+    {
+        Signal signal;
+        Config config;
+        CurvePresets::Shape shape;
+
+        // signal_config_shape, also the reference file's name
+        juce::String getName() const;
+    };
+
+    // The drum loop, with its fast onsets and decays, under every
+    // configuration with the linear curves
+    bool hasReferenceAudio(const Case& goldenCase);
+
+    // Every signal with every configuration and curve shape
+    std::vector<Case> makeCases();
+
+    juce::AudioBuffer<float> makeSignal(Signal signal, double rate = sampleRate);
+    juce::AudioBuffer<float> render(const Case& goldenCase);
+
+    // 64-bit FNV-1a of the sample bit patterns, as 16 hex digits
+    juce::String hash(const juce::AudioBuffer<float>& audio);
+
+    struct CaseReport
+    {
+        enum class Status
+        {
+            bitExact,
+            withinTolerance,
+            failed,
+            missing // no golden hash for the case
+        };
+
+        juce::String name;
+        Status status = Status::missing;
+        float maxDifferenceDb = -200.0f; // against the reference audio, over its length, when it was compared
+        juce::String detail;             // why a case failed
+    };
+
+    // Renders every case and writes golden.json, plus the reference audio of
+    // the cases that have it when withAudio is set, into folder
+    juce::Result record(const juce::File& folder, bool withAudio);
+
+    // Renders every case and compares it with the goldens in folder
+    juce::Result check(const juce::File& folder, float toleranceDb, std::vector<CaseReport>& reports);
+
+    //==============================================================================
+    // The eco envelope against the per-sample one. Every signal is rendered
+    // both ways with the RMS detector (eco does not apply to the others) at
+    // 44.1, 96 and 192 kHz, with attack/release of 1/10, 10/100 and 100/1000 ms
+    // and every preset curve shape. Wherever the input is above -60 dBFS, the
+    // gains the two apply may differ by at most maxEcoErrorDb, and by
+    // maxEcoRmsErrorDb RMS over the render. The worst measured cases are
+    // 0.90 dB, a single sample at a burst onset with a 1 ms attack at 192 kHz,
+    // and 0.025 dB RMS (drum loop, 44.1 kHz, 100/1000 ms); the bounds leave a
+    // little room over those for compiler and platform differences.
+    inline constexpr float maxEcoErrorDb = 0.95f;
+    inline constexpr float maxEcoRmsErrorDb = 0.03f;
+
+    struct EcoReport
+    {
+        juce::String name; // signal_rms_rate_attack_release_shape
+        float maxErrorDb = 0.0f;
+        float rmsErrorDb = 0.0f;
+
+        bool isWithinBound() const { return maxErrorDb <= maxEcoErrorDb && rmsErrorDb <= maxEcoRmsErrorDb; }
+    };
+
+    std::vector<EcoReport> checkEco();
+
+    //==============================================================================
+    // A mono external key on unlinked stereo audio keys both link groups, with
+    // oversampling off, 2x and 4x, switched every few blocks. The audio is the
+    // same on both channels, so they must come out bit-identical throughout.
+    juce::Result checkKeyOversampling();
+}
@@ -0,0 +1,306 @@
+#include <juce_core/juce_core.h>
+#include <iostream>
+#include "EngineBenchmark.h"
+#include "GoldenRender.h"
+
+namespace
+{
+   #if JUCE_DEBUG
+    constexpr bool isDebugBuild = true;
+   #else
+    constexpr bool isDebugBuild = false;
+   #endif
+
+    juce::var describeSystem()
+    {
+        auto* system = new juce::DynamicObject();
+        system->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        system->setProperty("cpu", juce::SystemStats::getCpuModel());
+        system->setProperty("num_cpus", juce::SystemStats::getNumCpus());
+        system->setProperty("juce_version", juce::SystemStats::getJUCEVersion());
+        system->setProperty("exact_math", SONDYCOMP_EXACT_MATH != 0);
+        system->setProperty("debug_build", isDebugBuild);
+        return system;
+    }
+
+    juce::var describeResult(const EngineBenchmark::Case& benchmarkCase, const EngineBenchmark::Result& result)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("state", EngineBenchmark::getName(benchmarkCase.state));
+        entry->setProperty("block_size", benchmarkCase.blockSize);
+        entry->setProperty("channels", benchmarkCase.numChannels);
+        entry->setProperty("sample_rate", benchmarkCase.sampleRate);
+        entry->setProperty("knee", benchmarkCase.knee);
+        entry->setProperty("shape", CurvePresets::getName(benchmarkCase.shape));
+        entry->setProperty("ns_per_sample", result.nsPerSample);
+        entry->setProperty("min_ns_per_sample", result.minNsPerSample);
+        entry->setProperty("realtime_multiple", result.getRealtimeMultiple(benchmarkCase));
+        return entry;
+    }
+
+    void runBenchmark(juce::ArgumentList args)
+    {
+        const bool full = args.removeOptionIfFound("--full");
+        const auto seconds = args.containsOption("--seconds") ? args.removeValueForOption("--seconds").getDoubleValue() : 1.0;
+        const auto numRuns = args.containsOption("--runs") ? args.removeValueForOption("--runs").getIntValue() : 5;
+        const auto outputFile = args.containsOption("--output") ? args.getFileForOptionAndRemove("--output") : juce::File();
+
+        if (seconds <= 0.0 || numRuns < 1)
+            juce::ConsoleApplication::fail("--seconds and --runs need positive values");
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail("Unexpected argument " + args[0].text);
+
+        const auto cases = EngineBenchmark::makeCases(full);
+        juce::Array<juce::var> results;
+
+        for (size_t index = 0; index < cases.size(); ++index)
+        {
+            const auto& benchmarkCase = cases[index];
+            const auto result = EngineBenchmark::measure(benchmarkCase, seconds, numRuns);
+            results.add(describeResult(benchmarkCase, result));
+
+            // Progress goes to stderr so stdout stays valid JSON
+            std::cerr << "[" << (index + 1) << "/" << cases.size() << "] " << EngineBenchmark::getName(benchmarkCase.state)
+                      << ", " << benchmarkCase.blockSize << " samples, " << benchmarkCase.numChannels << " ch, "
+                      << benchmarkCase.sampleRate << " Hz, " << benchmarkCase.knee << " dB knee, "
+                      << CurvePresets::getName(benchmarkCase.shape) << ": " << juce::String(result.nsPerSample, 2) << " ns/sample" << std::endl;
+        }
+
+        auto* report = new juce::DynamicObject();
+        report->setProperty("benchmark", "SondyComp Compressor::process");
+        report->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+        report->setProperty("system", describeSystem());
+        report->setProperty("seconds_per_run", seconds);
+        report->setProperty("runs", numRuns);
+        report->setProperty("results", results);
+
+        const auto json = juce::JSON::toString(juce::var(report));
+
+        if (outputFile == juce::File())
+        {
+            std::cout << json << std::endl;
+            return;
+        }
+
+        if (! outputFile.replaceWithText(json))
+            juce::ConsoleApplication::fail("Cannot write " + outputFile.getFullPathName());
+    }
+
+    // Reads a case back from an entry written by describeResult()
+    bool parseCase(const juce::var& entry, EngineBenchmark::Case& benchmarkCase)
+    {
+        bool foundState = false, foundShape = false;
+
+        for (int state = 0; state < EngineBenchmark::numInputStates; ++state)
+        {
+            if (entry["state"].toString() == EngineBenchmark::getName(static_cast<EngineBenchmark::InputState>(state)))
+            {
+                benchmarkCase.state = static_cast<EngineBenchmark::InputState>(state);
+                foundState = true;
+            }
+        }
+
+        for (int shape = 0; shape < CurvePresets::numShapes; ++shape)
+        {
+            if (entry["shape"].toString() == CurvePresets::getName(static_cast<CurvePresets::Shape>(shape)))
+            {
+                benchmarkCase.shape = static_cast<CurvePresets::Shape>(shape);
+                foundShape = true;
+            }
+        }
+
+        benchmarkCase.blockSize = static_cast<int>(entry["block_size"]);
+        benchmarkCase.numChannels = static_cast<int>(entry["channels"]);
+        benchmarkCase.sampleRate = static_cast<double>(entry["sample_rate"]);
+        benchmarkCase.knee = static_cast<float>(static_cast<double>(entry["knee"]));
+
+        return foundState && foundShape && benchmarkCase.blockSize > 0 && benchmarkCase.numChannels > 0 && benchmarkCase.sampleRate > 0.0;
+    }
+
+    // Golden renders; returns the number of cases that failed
+    int checkGoldens(const juce::File& folder, float toleranceDb)
+    {
+        std::vector<GoldenRender::CaseReport> reports;
+        if (const auto result = GoldenRender::check(folder, toleranceDb, reports); result.failed())
+            juce::ConsoleApplication::fail(result.getErrorMessage());
+
+        using Status = GoldenRender::CaseReport::Status;
+        int numFailed = 0;
+
+        for (const auto& report : reports)
+        {
+            std::cout << report.name << ": ";
+
+            switch (report.status)
+            {
+                case Status::bitExact:        std::cout << "bit-exact"; break;
+                case Status::withinTolerance: std::cout << "nulls to " << juce::String(report.maxDifferenceDb, 1) << " dBFS"; break;
+                case Status::failed:
+                case Status::missing:         std::cout << "FAILED, " << report.detail; ++numFailed; break;
+            }
+
+            std::cout << std::endl;
+        }
+
+        return numFailed;
+    }
+
+    // Eco envelope against per-sample; returns the number of cases out of bound
+    int checkEcoEnvelope()
+    {
+        int numFailed = 0;
+
+        for (const auto& report : GoldenRender::checkEco())
+        {
+            std::cout << report.name << ": eco within " << juce::String(report.maxErrorDb, 3) << " dB, "
+                      << juce::String(report.rmsErrorDb, 3) << " dB RMS";
+
+            if (! report.isWithinBound())
+            {
+                std::cout << " FAILED, bound is " << juce::String(GoldenRender::maxEcoErrorDb, 3) << " dB, "
+                          << juce::String(GoldenRender::maxEcoRmsErrorDb, 3) << " dB RMS";
+                ++numFailed;
+            }
+
+            std::cout << std::endl;
+        }
+
+        return numFailed;
+    }
+
+    // External key through the oversamplers; returns 1 if it failed
+    int checkKeyPath()
+    {
+        const auto result = GoldenRender::checkKeyOversampling();
+        std::cout << "mono key with oversampling switched: " << (result.wasOk() ? juce::String("ok") : "FAILED, " + result.getErrorMessage()) << std::endl;
+        return result.wasOk() ? 0 : 1;
+    }
+
+    // Times every case in a stored benchmark run again; returns the number
+    // that got slower than maxRegressionPercent allows
+    int checkPerformance(const juce::File& baselineFile, double maxRegressionPercent, double seconds, int numRuns)
+    {
+        juce::var baseline;
+        if (const auto result = juce::JSON::parse(baselineFile.loadFileAsString(), baseline); result.failed())
+            juce::ConsoleApplication::fail("Cannot read " + baselineFile.getFullPathName() + ": " + result.getErrorMessage());
+
+        const auto* entries = baseline["results"].getArray();
+        if (entries == nullptr || entries->isEmpty())
+            juce::ConsoleApplication::fail(baselineFile.getFullPathName() + " has no results");
+
+        int numFailed = 0;
+
+        for (const auto& entry : *entries)
+        {
+            EngineBenchmark::Case benchmarkCase;
+            if (! parseCase(entry, benchmarkCase))
+                juce::ConsoleApplication::fail(baselineFile.getFullPathName() + " has an unreadable result: " + juce::JSON::toString(entry, true));
+
+            const auto baselineNs = static_cast<double>(entry["ns_per_sample"]);
+            const auto nowNs = EngineBenchmark::measure(benchmarkCase, seconds, numRuns).nsPerSample;
+            const auto changePercent = baselineNs > 0.0 ? 100.0 * (nowNs / baselineNs - 1.0) : 0.0;
+            const bool regressed = changePercent > maxRegressionPercent;
+
+            std::cout << EngineBenchmark::getName(benchmarkCase.state) << ", " << benchmarkCase.blockSize << " samples, "
+                      << benchmarkCase.numChannels << " ch, " << benchmarkCase.sampleRate << " Hz, " << benchmarkCase.knee << " dB knee, "
+                      << CurvePresets::getName(benchmarkCase.shape) << ": " << juce::String(baselineNs, 2) << " -> "
+                      << juce::String(nowNs, 2) << " ns/sample (" << (changePercent >= 0.0 ? "+" : "") << juce::String(changePercent, 1) << "%)"
+                      << (regressed ? " REGRESSED" : "") << std::endl;
+
+            if (regressed)
+                ++numFailed;
+        }
+
+        return numFailed;
+    }
+
+    void runChecks(juce::ArgumentList args)
+    {
+        args.removeOptionIfFound("--check");
+
+        const auto goldenFolder = args.containsOption("--golden") ? args.getFileForOptionAndRemove("--golden") : juce::File();
+        const bool update = args.removeOptionIfFound("--update");
+        const bool withAudio = ! args.removeOptionIfFound("--hashes-only");
+        const auto toleranceDb = args.containsOption("--tolerance") ? args.removeValueForOption("--tolerance").getFloatValue() : -120.0f;
+        const auto baselineFile = args.containsOption("--baseline") ? args.getExistingFileForOptionAndRemove("--baseline") : juce::File();
+        const auto maxRegression = args.containsOption("--max-regression") ? args.removeValueForOption("--max-regression").getDoubleValue() : 10.0;
+        const auto seconds = args.containsOption("--seconds") ? args.removeValueForOption("--seconds").getDoubleValue() : 1.0;
+        const auto numRuns = args.containsOption("--runs") ? args.removeValueForOption("--runs").getIntValue() : 5;
+
+        if (seconds <= 0.0 || numRuns < 1)
+            juce::ConsoleApplication::fail("--seconds and --runs need positive values");
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail("Unexpected argument " + args[0].text);
+
+        if (goldenFolder == juce::File() && (update || baselineFile == juce::File()))
+            juce::ConsoleApplication::fail("--check needs --golden, --baseline or both");
+
+        if (update)
+        {
+            if (const auto result = GoldenRender::record(goldenFolder, withAudio); result.failed())
+                juce::ConsoleApplication::fail(result.getErrorMessage());
+
+            std::cout << "Recorded " << GoldenRender::makeCases().size() << " golden renders in " << goldenFolder.getFullPathName() << std::endl;
+            return;
+        }
+
+        // Goldens, eco and key path need no baseline; a performance run alone skips them
+        const bool checkRenders = goldenFolder != juce::File();
+        const auto numRenderFailures = checkRenders ? checkGoldens(goldenFolder, toleranceDb) : 0;
+        const auto numEcoFailures = checkRenders ? checkEcoEnvelope() : 0;
+        const auto numKeyFailures = checkRenders ? checkKeyPath() : 0;
+        const auto numRegressions = baselineFile != juce::File() ? checkPerformance(baselineFile, maxRegression, seconds, numRuns) : 0;
+
+        if (numRenderFailures > 0 || numEcoFailures > 0 || numKeyFailures > 0 || numRegressions > 0)
+            juce::ConsoleApplication::fail(juce::String(numRenderFailures) + " golden renders failed, "
+                                           + juce::String(numEcoFailures) + " eco renders out of bound, "
+                                           + juce::String(numKeyFailures) + " key path checks failed, "
+                                           + juce::String(numRegressions) + " cases regressed by more than "
+                                           + juce::String(maxRegression, 1) + "%");
+
+        if (checkRenders)
+            std::cout << "All golden renders match, eco within bound, key path consistent" << std::endl;
+
+        if (baselineFile != juce::File())
+            std::cout << "No performance regressions" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+
+    app.addHelpCommand("--help|-h", "SondyComp engine benchmark", false);
+    app.addDefaultCommand({ "",
+                            "[--full] [--seconds <s>] [--runs <n>] [--output <file.json>]",
+                            "Times Compressor::process in ns/sample and prints the results as JSON",
+                            "Sweeps block size (16-4096), channel count (1/2/8/16), sample rate (44.1-384 kHz), knee and\n"
+                            "curve shape one at a time for each input state: silence, below threshold, heavy compression\n"
+                            "and rapid attack/release toggling. --full runs the whole cross product instead.\n"
+                            "Each case is timed over --runs runs (default 5) of --seconds of audio (default 1) after a\n"
+                            "warm-up run; ns_per_sample is the median, per channel. Progress goes to stderr.",
+                            [](const juce::ArgumentList& args) { runBenchmark(args); } });
+
+    app.addCommand({ "--check",
+                     "--check [--golden <folder> [--update [--hashes-only]] [--tolerance <dBFS>]]\n"
+                     "    [--baseline <benchmark.json> [--max-regression <percent>] [--seconds <s>] [--runs <n>]]",
+                     "Checks golden renders and performance against stored baselines",
+                     "Renders a sweep, tone bursts and a drum loop, all synthesized, through the compressor with every\n"
+                     "preset curve shape under peak, RMS/eco and hybrid with 2x oversampling and lookahead. Each\n"
+                     "render must hash the same as its golden or, for the few cases with reference audio, null against\n"
+                     "its first 0.5 s within --tolerance (default -120 dBFS). --update records the goldens instead;\n"
+                     "--hashes-only leaves the reference audio out. The reference set is in Benchmark/Golden.\n"
+                     "Every signal is also rendered with the RMS detector at 44.1-192 kHz, eco against per-sample\n"
+                     "envelope, and fails if the gains differ by more than 0.95 dB, or 0.03 dB RMS.\n"
+                     "A mono external key must also key unlinked stereo audio the same way while oversampling is\n"
+                     "switched between off, 2x and 4x.\n"
+                     "With --baseline, every case in a JSON file written by the benchmark is timed again and fails if\n"
+                     "it is more than --max-regression percent slower (default 10). Either --golden or --baseline may\n"
+                     "be left out to run only the other. CTest runs both, labelled golden and performance.\n"
+                     "Exits with an error if anything fails, for use in CI.",
+                     [](const juce::ArgumentList& args) { runChecks(args); } });
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,278 @@
+#include "AsyncFileOutputStream.h"
+
+#if SONDYCOMP_IO_URING
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <liburing.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+// Writes one chunk at a time in the background
+class AsyncFileOutputStream::Backend
+{
+public:
+    virtual ~Backend() = default;
+
+    virtual bool isIoUring() const = 0;
+
+    // Starts writing numBytes of data at offset. Only called with nothing in flight
+    virtual void start(const char* data, size_t numBytes, juce::int64 offset) = 0;
+
+    // Waits for the write in flight, if any; false if it failed
+    virtual bool wait() = 0;
+};
+
+//==============================================================================
+class AsyncFileOutputStream::PoolBackend : public Backend
+{
+public:
+    explicit PoolBackend(const juce::File& file)
+        : stream(file, 0) // unbuffered: chunks go straight to write()
+    {
+        if (stream.openedOk())
+            opened = stream.setPosition(0) && stream.truncate().wasOk();
+
+        done.signal();
+    }
+
+    ~PoolBackend() override { wait(); }
+
+    bool openedOk() const { return opened; }
+    bool isIoUring() const override { return false; }
+
+    void start(const char* data, size_t numBytes, juce::int64 offset) override
+    {
+        done.reset();
+        writePool->pool.addJob([this, data, numBytes, offset]
+        {
+            succeeded = stream.setPosition(offset) && stream.write(data, numBytes);
+            done.signal();
+        });
+    }
+
+    bool wait() override
+    {
+        done.wait();
+        return succeeded;
+    }
+
+private:
+    // A few threads shared by every stream; each stream has at most one job queued
+    struct WritePool
+    {
+        juce::ThreadPool pool { juce::jlimit(2, 8, juce::SystemStats::getNumCpus() / 4) };
+    };
+
+    juce::SharedResourcePointer<WritePool> writePool;
+    juce::FileOutputStream stream;
+    juce::WaitableEvent done { true };
+    bool succeeded = true;
+    bool opened = false;
+};
+
+//==============================================================================
+#if SONDYCOMP_IO_URING
+class AsyncFileOutputStream::IoUringBackend : public Backend
+{
+public:
+    // nullptr if the kernel won't set up a ring (too old, or blocked by a
+    // sandbox) or the file can't be opened
+    static std::unique_ptr<IoUringBackend> create(const juce::File& file)
+    {
+        std::unique_ptr<IoUringBackend> backend(new IoUringBackend());
+
+        if (io_uring_queue_init(2, &backend->ring, 0) < 0)
+            return nullptr;
+
+        backend->hasRing = true;
+        backend->fd = ::open(file.getFullPathName().toRawUTF8(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (backend->fd < 0)
+            return nullptr;
+
+        return backend;
+    }
+
+    ~IoUringBackend() override
+    {
+        wait();
+
+        if (fd >= 0)
+            ::close(fd);
+
+        if (hasRing)
+            io_uring_queue_exit(&ring);
+    }
+
+    bool isIoUring() const override { return true; }
+
+    void start(const char* data, size_t numBytes, juce::int64 offset) override
+    {
+        pending = data;
+        remaining = numBytes;
+        pendingOffset = offset;
+        succeeded = submit();
+    }
+
+    bool wait() override
+    {
+        while (inFlight)
+        {
+            io_uring_cqe* cqe = nullptr;
+            const auto error = io_uring_wait_cqe(&ring, &cqe);
+            if (error == -EINTR)
+                continue;
+
+            inFlight = false;
+            if (error < 0)
+                return succeeded = false;
+
+            const auto written = cqe->res;
+            io_uring_cqe_seen(&ring, cqe);
+
+            if (written == -EINTR || written == -EAGAIN)
+            {
+                succeeded = submit();
+                continue;
+            }
+
+            if (written <= 0)
+                return succeeded = false;
+
+            // Short writes carry on from where they stopped
+            pending += written;
+            remaining -= static_cast<size_t>(written);
+            pendingOffset += written;
+
+            if (remaining > 0)
+                succeeded = submit();
+        }
+
+        return succeeded;
+    }
+
+private:
+    IoUringBackend() = default;
+
+    bool submit()
+    {
+        auto* sqe = io_uring_get_sqe(&ring);
+        if (sqe == nullptr)
+            return false;
+
+        io_uring_prep_write(sqe, fd, pending, static_cast<unsigned int>(remaining), static_cast<__u64>(pendingOffset));
+        if (io_uring_submit(&ring) < 1)
+            return false;
+
+        inFlight = true;
+        return true;
+    }
+
+    io_uring ring {};
+    bool hasRing = false;
+    int fd = -1;
+
+    const char* pending = nullptr;
+    size_t remaining = 0;
+    juce::int64 pendingOffset = 0;
+    bool inFlight = false;
+    bool succeeded = true;
+};
+#endif
+
+//==============================================================================
+AsyncFileOutputStream::AsyncFileOutputStream(const juce::File& file, std::atomic<bool>* flag)
+    : failureFlag(flag)
+{
+   #if SONDYCOMP_IO_URING
+    backend = IoUringBackend::create(file);
+   #endif
+
+    if (backend == nullptr)
+    {
+        auto poolBackend = std::make_unique<PoolBackend>(file);
+        if (! poolBackend->openedOk())
+            return;
+
+        backend = std::move(poolBackend);
+    }
+
+    for (auto& chunk : chunks)
+        chunk.malloc(chunkBytes);
+
+    opened = true;
+}
+
+AsyncFileOutputStream::~AsyncFileOutputStream()
+{
+    if (opened)
+        flush();
+}
+
+bool AsyncFileOutputStream::usesIoUring() const
+{
+    return backend != nullptr && backend->isIoUring();
+}
+
+void AsyncFileOutputStream::waitForBackend()
+{
+    if (backend->wait())
+        return;
+
+    failed = true;
+    if (failureFlag != nullptr)
+        *failureFlag = true;
+}
+
+void AsyncFileOutputStream::submitChunk()
+{
+    // The other chunk has to be on disk before it is filled again
+    waitForBackend();
+
+    backend->start(chunks[currentChunk].get(), chunkFill, chunkOffset);
+
+    chunkOffset += static_cast<juce::int64>(chunkFill);
+    chunkFill = 0;
+    currentChunk ^= 1;
+}
+
+void AsyncFileOutputStream::flush()
+{
+    if (chunkFill > 0)
+        submitChunk();
+
+    waitForBackend();
+}
+
+bool AsyncFileOutputStream::setPosition(juce::int64 newPosition)
+{
+    if (! opened)
+        return false;
+
+    flush();
+    chunkOffset = newPosition;
+    return ! failed;
+}
+
+bool AsyncFileOutputStream::write(const void* data, size_t numBytes)
+{
+    if (! opened || failed)
+        return false;
+
+    auto* source = static_cast<const char*>(data);
+
+    while (numBytes > 0)
+    {
+        const auto numToCopy = juce::jmin(numBytes, static_cast<size_t>(chunkBytes) - chunkFill);
+        std::memcpy(chunks[currentChunk].get() + chunkFill, source, numToCopy);
+        chunkFill += numToCopy;
+        source += numToCopy;
+        numBytes -= numToCopy;
+
+        if (chunkFill == static_cast<size_t>(chunkBytes))
+            submitChunk();
+    }
+
+    return ! failed;
+}
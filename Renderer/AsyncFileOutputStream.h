@@ -0,0 +1,64 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+// A file output stream that writes in the background through two chunks:
+// while one is on its way to disk the writer fills the other, so the render
+// thread only waits when it gets a whole chunk ahead of the disk.
+//
+// On Linux builds with liburing (SONDYCOMP_IO_URING) chunks are submitted to
+// an io_uring of the stream's own. Elsewhere, or where the kernel refuses a
+// ring, they are written by a small thread pool shared by all streams. Only
+// one chunk is in flight per stream at a time, so writes land in order.
+//
+// Seeking (audio writers go back to finish their headers) waits for the write
+// in flight and flushes the current chunk first. The file is replaced, not
+// appended to.
+class AsyncFileOutputStream : public juce::OutputStream
+{
+public:
+    static constexpr int chunkBytes = 1 << 20;
+
+    // failureFlag, if given, is also set when a write fails. Audio writers own
+    // and delete their stream, so this is how a caller learns whether the
+    // final flush landed; it has to outlive the stream
+    explicit AsyncFileOutputStream(const juce::File& file, std::atomic<bool>* failureFlag = nullptr);
+    ~AsyncFileOutputStream() override;
+
+    bool openedOk() const { return opened; }
+    bool usesIoUring() const;
+
+    // True once any write has failed; check after flush() to know everything landed
+    bool hasFailed() const { return failed; }
+
+    void flush() override;
+    bool setPosition(juce::int64 newPosition) override;
+    juce::int64 getPosition() override { return chunkOffset + static_cast<juce::int64>(chunkFill); }
+    bool write(const void* data, size_t numBytes) override;
+
+private:
+    class Backend;
+    class PoolBackend;
+   #if SONDYCOMP_IO_URING
+    class IoUringBackend;
+   #endif
+
+    // Hands the current chunk to the backend and switches to the other one,
+    // waiting for it if it is still being written
+    void submitChunk();
+    void waitForBackend();
+
+    std::unique_ptr<Backend> backend;
+    juce::HeapBlock<char> chunks[2];
+    int currentChunk = 0;
+    size_t chunkFill = 0;
+    juce::int64 chunkOffset = 0; // file position of the current chunk's first byte
+    bool opened = false;
+    bool failed = false;
+    std::atomic<bool>* failureFlag = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE(AsyncFileOutputStream)
+};
@@ -0,0 +1,115 @@
+#include "BatchRenderer.h"
+#include "WorkStealingQueue.h"
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+BatchRenderer::BatchRenderer(const RenderPreset& preset, const Options& newOptions)
+    : options(newOptions)
+{
+    options.numWorkers = juce::jmax(1, options.numWorkers);
+    if (options.numIoThreads <= 0)
+        options.numIoThreads = (options.numWorkers + 7) / 8;
+
+    for (int index = 0; index < options.numIoThreads; ++index)
+    {
+        ioThreads.push_back(std::make_unique<juce::TimeSliceThread>("Render I/O " + juce::String(index + 1)));
+        ioThreads.back()->startThread();
+    }
+
+    for (int worker = 0; worker < options.numWorkers; ++worker)
+    {
+        workers.push_back(std::make_unique<FileRenderer>(preset));
+        workers.back()->setBackgroundIo(ioThreads[static_cast<size_t>(worker % options.numIoThreads)].get(),
+                                        options.readAheadSamples, options.writeBehindSamples);
+    }
+}
+
+BatchRenderer::~BatchRenderer()
+{
+    // Workers hold FIFOs registered with the I/O threads
+    workers.clear();
+
+    for (auto& thread : ioThreads)
+        thread->stopThread(2000);
+}
+
+juce::int64 BatchRenderer::getMemoryBound(int numChannels) const
+{
+    const auto samplesPerWorker = static_cast<juce::int64>(juce::jmax(FileRenderer::blockSize, options.readAheadSamples)
+                                                           + juce::jmax(2 * FileRenderer::blockSize, options.writeBehindSamples)
+                                                           + FileRenderer::blockSize);
+
+    // Plus the output stream's two chunks; memory-mapped inputs live in the page cache
+    const auto bytesPerWorker = samplesPerWorker * numChannels * static_cast<juce::int64>(sizeof(float))
+                              + 2 * AsyncFileOutputStream::chunkBytes;
+
+    return bytesPerWorker * getNumWorkers();
+}
+
+BatchRenderer::Summary BatchRenderer::run(const std::vector<Job>& jobs, FileCallback onFileDone, int numWorkersToUse)
+{
+    const int numWorkers = numWorkersToUse > 0 ? juce::jmin(numWorkersToUse, getNumWorkers()) : getNumWorkers();
+
+    Summary summary;
+    summary.numWorkers = numWorkers;
+    summary.files.resize(jobs.size());
+
+    // Largest files first, dealt round-robin, so the long renders start early
+    // and stealing only has small files left to balance at the end
+    std::vector<juce::int64> sizes(jobs.size());
+    for (size_t job = 0; job < jobs.size(); ++job)
+        sizes[job] = jobs[job].input.getSize();
+
+    std::vector<int> order(jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sizes](int a, int b) { return sizes[static_cast<size_t>(a)] > sizes[static_cast<size_t>(b)]; });
+
+    WorkStealingQueue queue(numWorkers);
+    for (size_t rank = 0; rank < order.size(); ++rank)
+        queue.push(static_cast<int>(rank % static_cast<size_t>(numWorkers)), order[rank]);
+
+    std::mutex reportMutex;
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto workerLoop = [&](int worker)
+    {
+        auto& renderer = *workers[static_cast<size_t>(worker)];
+
+        for (int job = queue.pop(worker); job >= 0; job = queue.pop(worker))
+        {
+            auto& report = summary.files[static_cast<size_t>(job)];
+            report.input = jobs[static_cast<size_t>(job)].input;
+            report.output = jobs[static_cast<size_t>(job)].output;
+            report.worker = worker;
+            report.result = renderer.render(report.input, report.output, &report.stats);
+
+            const std::lock_guard<std::mutex> lock(reportMutex);
+            if (onFileDone != nullptr)
+                onFileDone(report);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int worker = 1; worker < numWorkers; ++worker)
+        threads.emplace_back(workerLoop, worker);
+
+    // The calling thread is worker 0
+    workerLoop(0);
+
+    for (auto& thread : threads)
+        thread.join();
+
+    summary.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+    for (const auto& report : summary.files)
+    {
+        if (report.result.failed())
+            ++summary.numFailed;
+        else
+            summary.audioSeconds += report.stats.audioSeconds;
+    }
+
+    return summary;
+}
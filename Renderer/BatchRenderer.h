@@ -0,0 +1,80 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "FileRenderer.h"
+#include "RenderPreset.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// Renders many files at once on a fixed set of worker threads.
+//
+// Each worker owns a FileRenderer (its own Compressor, block buffer and format
+// readers), created up front and reused across files and batches. Files are
+// dealt to the workers largest first and balanced by work stealing (see
+// WorkStealingQueue).
+//
+// Reads and writes go through fixed-size read-ahead and write-behind FIFOs
+// on a few shared I/O threads, so memory stays bounded however long the
+// files are: getMemoryBound() gives the total for the widest file. Inputs
+// that can be memory-mapped are read from the mapping instead.
+class BatchRenderer
+{
+public:
+    struct Options
+    {
+        int numWorkers = juce::SystemStats::getNumCpus();
+        int numIoThreads = 0;             // 0: one per 8 workers
+        int readAheadSamples = 1 << 16;   // per channel, per worker
+        int writeBehindSamples = 1 << 16; // per channel, per worker
+    };
+
+    struct Job
+    {
+        juce::File input, output;
+    };
+
+    struct FileReport
+    {
+        juce::File input, output;
+        juce::Result result = juce::Result::ok();
+        FileRenderer::Stats stats;
+        int worker = 0;
+    };
+
+    struct Summary
+    {
+        std::vector<FileReport> files;  // in job order
+        int numWorkers = 0;
+        int numFailed = 0;
+        double audioSeconds = 0.0;      // all files
+        double wallSeconds = 0.0;       // whole batch
+
+        // Audio rendered per second of wall-clock time, across all workers
+        double getRealtimeMultiple() const { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+    };
+
+    // Called on a worker thread as each file finishes; calls are serialized
+    using FileCallback = std::function<void(const FileReport&)>;
+
+    BatchRenderer(const RenderPreset& preset, const Options& options);
+    ~BatchRenderer();
+
+    int getNumWorkers() const { return static_cast<int>(workers.size()); }
+
+    // Bytes held in I/O FIFOs, output chunks and block buffers with every
+    // worker busy on a file of numChannels channels
+    juce::int64 getMemoryBound(int numChannels) const;
+
+    // Renders every job, using the first numWorkersToUse workers (all of them
+    // if 0 or more than there are), and returns once all are done
+    Summary run(const std::vector<Job>& jobs, FileCallback onFileDone = nullptr, int numWorkersToUse = 0);
+
+private:
+    Options options;
+    std::vector<std::unique_ptr<FileRenderer>> workers;
+    std::vector<std::unique_ptr<juce::TimeSliceThread>> ioThreads;
+
+    JUCE_DECLARE_NON_COPYABLE(BatchRenderer)
+};
@@ -0,0 +1,293 @@
+#include "FileRenderer.h"
+
+namespace
+{
+    // The input's bit depth if the output format has it, else the deepest it has
+    int chooseBitDepth(juce::AudioFormat& format, int inputBitDepth)
+    {
+        const auto depths = format.getPossibleBitDepths();
+        if (depths.contains(inputBitDepth))
+            return inputBitDepth;
+
+        int deepest = 16;
+        for (auto depth : depths)
+            deepest = juce::jmax(deepest, depth);
+
+        return deepest;
+    }
+
+    // Audio written behind the render by an I/O thread, through a FIFO of a
+    // fixed size. Unlike juce::AudioFormatWriter::ThreadedWriter, write()
+    // waits for room when the FIFO is full; the I/O thread signals each time
+    // it drains some
+    class WriteBehindWriter : private juce::TimeSliceClient
+    {
+    public:
+        WriteBehindWriter(juce::AudioFormatWriter* writerToOwn, juce::TimeSliceThread& ioThread, int numSamples)
+            : writer(writerToOwn), thread(ioThread), fifo(numSamples + 1),
+              buffer(static_cast<int>(writerToOwn->getNumChannels()), numSamples + 1)
+        {
+            thread.addTimeSliceClient(this);
+        }
+
+        // Writes whatever is still queued before deleting the writer
+        ~WriteBehindWriter() override
+        {
+            thread.removeTimeSliceClient(this);
+            while (writePendingData() == 0) {}
+        }
+
+        // False if an earlier write to the file failed
+        bool write(const float* const* data, int numSamples)
+        {
+            jassert(numSamples <= fifo.getTotalSize() - 1);
+
+            while (fifo.getFreeSpace() < numSamples && ! failed)
+            {
+                // The I/O thread may be sleeping between time slices
+                thread.notify();
+                spaceFreed.wait();
+            }
+
+            if (failed)
+                return false;
+
+            int start1, size1, start2, size2;
+            fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                buffer.copyFrom(channel, start1, data[channel], size1);
+                if (size2 > 0)
+                    buffer.copyFrom(channel, start2, data[channel] + size1, size2);
+            }
+
+            fifo.finishedWrite(size1 + size2);
+            return true;
+        }
+
+    private:
+        int useTimeSlice() override { return writePendingData(); }
+
+        // 0 after writing something, else how long the I/O thread may sleep
+        int writePendingData()
+        {
+            const auto numReady = fifo.getNumReady();
+            if (numReady <= 0)
+                return 10;
+
+            int start1, size1, start2, size2;
+            fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+            if (! writer->writeFromAudioSampleBuffer(buffer, start1, size1)
+                || (size2 > 0 && ! writer->writeFromAudioSampleBuffer(buffer, start2, size2)))
+                failed = true;
+
+            fifo.finishedRead(size1 + size2);
+            spaceFreed.signal();
+            return 0;
+        }
+
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        juce::TimeSliceThread& thread;
+        juce::AbstractFifo fifo;
+        juce::AudioBuffer<float> buffer;
+        juce::WaitableEvent spaceFreed;
+        std::atomic<bool> failed { false };
+
+        JUCE_DECLARE_NON_COPYABLE(WriteBehindWriter)
+    };
+}
+
+FileRenderer::FileRenderer(const RenderPreset& presetToUse)
+    : preset(presetToUse)
+{
+    formatManager.registerBasicFormats();
+
+    // Stereo at the block size up front; only wider files grow it
+    buffer.setSize(2, blockSize);
+    channelPointers.reserve(2);
+}
+
+void FileRenderer::setBackgroundIo(juce::TimeSliceThread* ioThread, int newReadAheadSamples, int newWriteBehindSamples)
+{
+    backgroundThread = ioThread;
+
+    // The write FIFO has to take at least one whole block
+    readAheadSamples = juce::jmax(blockSize, newReadAheadSamples);
+    writeBehindSamples = juce::jmax(2 * blockSize, newWriteBehindSamples);
+}
+
+std::unique_ptr<juce::AudioFormatReader> FileRenderer::createReader(const juce::File& file)
+{
+    if (auto* format = formatManager.findFormatForFileExtension(file.getFileExtension()))
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+        if (mapped != nullptr && mapped->mapEntireFile())
+            return mapped;
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(file));
+}
+
+std::unique_ptr<juce::AudioFormatWriter> FileRenderer::createWriter(const juce::File& file, const juce::AudioFormatReader& source,
+                                                                    int bitDepth, juce::String& error, std::atomic<bool>* writeFailed)
+{
+    auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+    if (format == nullptr)
+    {
+        error = "no audio format for " + file.getFileExtension();
+        return nullptr;
+    }
+
+    auto stream = std::make_unique<AsyncFileOutputStream>(file, writeFailed);
+    if (! stream->openedOk())
+    {
+        error = "cannot open the file";
+        return nullptr;
+    }
+
+    if (bitDepth == 0)
+        bitDepth = chooseBitDepth(*format, static_cast<int>(source.bitsPerSample));
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), source.sampleRate, source.numChannels,
+                                                                             bitDepth, source.metadataValues, 0));
+    if (writer == nullptr)
+    {
+        error = format->getFormatName() + " cannot hold " + juce::String(source.numChannels)
+              + " channels at " + juce::String(bitDepth) + " bits";
+        return nullptr;
+    }
+
+    stream.release(); // now owned by the writer
+    return writer;
+}
+
+template <typename WriteBlock>
+juce::Result FileRenderer::renderSamples(juce::AudioFormatReader& reader, juce::int64 start, juce::int64 end,
+                                         juce::int64 preRollSamples, WriteBlock&& writeBlock)
+{
+    const auto numChannels = static_cast<int>(reader.numChannels);
+    const auto length = reader.lengthInSamples;
+
+    // Hosts flush denormals for the plugin; without it gain reduction tails
+    // decaying towards zero run several times slower
+    const juce::ScopedNoDenormals noDenormals;
+
+    preset.applyTo(compressor);
+    compressor.prepare(reader.sampleRate, blockSize, numChannels, numChannels);
+    preset.applyLinkGroups(compressor, numChannels);
+    buffer.setSize(numChannels, blockSize, false, false, true);
+    channelPointers.resize(static_cast<size_t>(numChannels));
+
+    // Output sample i leaves the compressor with input sample i + latency, so
+    // the delay is dropped from the start and flushed out with silence at the
+    // end. Blocks stay on the whole-file grid, including the last one, so a
+    // range sees exactly the block boundaries a whole-file render does
+    const auto latency = static_cast<juce::int64>(compressor.getLatencySamples());
+    const auto keepFrom = start + latency;
+    const auto keepTo = end + latency;
+    const auto first = juce::jmax(static_cast<juce::int64>(0), (start - preRollSamples) / blockSize * blockSize);
+
+    for (juce::int64 position = first; position < keepTo; position += blockSize)
+    {
+        const auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(blockSize), length + latency - position));
+        const auto numToRead = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(numSamples), length - position));
+
+        if (numToRead > 0 && ! reader.read(&buffer, 0, numToRead, position, true, true))
+            return juce::Result::fail("Read error");
+
+        if (numToRead < numSamples)
+            buffer.clear(numToRead, numSamples - numToRead);
+
+        compressor.process(juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, static_cast<size_t>(numSamples)));
+
+        const auto from = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(numSamples), keepFrom - position));
+        const auto to = static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(numSamples), keepTo - position));
+
+        if (to > from && ! writeBlock(from, to - from))
+            return juce::Result::fail("Write error");
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result FileRenderer::renderRange(juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer,
+                                       juce::int64 start, juce::int64 end, juce::int64 preRollSamples)
+{
+    return renderSamples(reader, start, end, preRollSamples, [this, &writer](int startSample, int numSamples)
+    {
+        return writer.writeFromAudioSampleBuffer(buffer, startSample, numSamples);
+    });
+}
+
+juce::Result FileRenderer::render(const juce::File& input, const juce::File& output, Stats* stats)
+{
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto reader = createReader(input);
+    if (reader == nullptr)
+        return juce::Result::fail("Cannot read " + input.getFullPathName());
+
+    const auto length = reader->lengthInSamples;
+    const auto sampleRate = reader->sampleRate;
+
+    // Written next to the target and moved over it once complete, so a failed
+    // render never leaves a truncated file behind
+    juce::TemporaryFile temporary(output);
+    juce::String error;
+    std::atomic<bool> writeFailed { false };
+    auto writer = createWriter(temporary.getFile(), *reader, 0, error, &writeFailed);
+    if (writer == nullptr)
+        return juce::Result::fail("Cannot write " + output.getFullPathName() + ": " + error);
+
+    // With background I/O the reader fills a read-ahead FIFO and the writer
+    // drains a write-behind FIFO on the I/O thread; both are fixed-size. A
+    // mapped reader is already just a copy out of memory
+    std::unique_ptr<WriteBehindWriter> writeBehindWriter;
+    if (backgroundThread != nullptr)
+    {
+        if (dynamic_cast<juce::MemoryMappedAudioFormatReader*>(reader.get()) == nullptr)
+        {
+            auto* bufferingReader = new juce::BufferingAudioReader(reader.release(), *backgroundThread, readAheadSamples);
+            bufferingReader->setReadTimeout(-1);
+            reader.reset(bufferingReader);
+        }
+
+        writeBehindWriter = std::make_unique<WriteBehindWriter>(writer.release(), *backgroundThread, writeBehindSamples);
+    }
+
+    const auto result = renderSamples(*reader, 0, length, 0, [this, &writer, &writeBehindWriter](int startSample, int numSamples)
+    {
+        if (writeBehindWriter == nullptr)
+            return writer->writeFromAudioSampleBuffer(buffer, startSample, numSamples);
+
+        // A full FIFO means the disk is behind; wait for it rather than grow
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            channelPointers[static_cast<size_t>(channel)] = buffer.getReadPointer(channel, startSample);
+
+        return writeBehindWriter->write(channelPointers.data(), numSamples);
+    });
+
+    // Destroying the writers flushes whatever is still queued
+    writeBehindWriter.reset();
+    writer.reset();
+    reader.reset();
+
+    if (result.failed())
+        return juce::Result::fail(result.getErrorMessage() + " rendering " + input.getFullPathName());
+
+    if (writeFailed)
+        return juce::Result::fail("Write error in " + output.getFullPathName());
+
+    if (! temporary.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Cannot replace " + output.getFullPathName());
+
+    if (stats != nullptr)
+    {
+        stats->audioSeconds = static_cast<double>(length) / sampleRate;
+        stats->renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    }
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "AsyncFileOutputStream.h"
+#include "Compressor.h"
+#include "RenderPreset.h"
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+// Renders audio files through the Compressor engine, one file at a time,
+// without a plugin host. The compressor and the block buffer are reused from
+// file to file and only reallocated when prepare() needs to.
+//
+// Output is latency-compensated: the samples the compressor delays by are
+// dropped from the start, and the tail is flushed with silence, so the output
+// lines up with the input and has the same length.
+//
+// Inputs the format can memory-map (PCM WAV, RF64 and AIFF) are read straight
+// from the mapping into the block buffer, without read calls or a copy out of
+// the page cache. Outputs go through an AsyncFileOutputStream.
+class FileRenderer
+{
+public:
+    static constexpr int blockSize = 4096;
+
+    struct Stats
+    {
+        double audioSeconds = 0.0;   // length of the file
+        double renderSeconds = 0.0;  // wall-clock time, including I/O
+
+        double getRealtimeMultiple() const { return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0; }
+    };
+
+    explicit FileRenderer(const RenderPreset& preset);
+
+    // Formats the renderer can read and write (WAV, AIFF, FLAC, ...)
+    juce::AudioFormatManager& getFormatManager() { return formatManager; }
+
+    // Read ahead of and write behind the DSP on ioThread, through FIFOs of a
+    // fixed number of samples per channel. Without it (nullptr, the default)
+    // reads and writes happen inline between blocks. Memory-mapped inputs
+    // skip the read-ahead FIFO
+    void setBackgroundIo(juce::TimeSliceThread* ioThread, int readAheadSamples, int writeBehindSamples);
+
+    // Renders input into output, replacing it. The output format follows the
+    // output file's extension, at the input's bit depth where it supports it
+    juce::Result render(const juce::File& input, const juce::File& output, Stats* stats = nullptr);
+
+    // Renders samples [start, end) of reader into writer. preRollSamples of
+    // input before start are run through the compressor first, so its state
+    // has settled by start; their output is discarded. The pre-roll begins on
+    // a block boundary counted from the start of the file, so blocks line up
+    // with a render of the whole file
+    juce::Result renderRange(juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer,
+                             juce::int64 start, juce::int64 end, juce::int64 preRollSamples);
+
+    // A reader for file, memory-mapped where the format allows; nullptr if
+    // the file can't be read
+    std::unique_ptr<juce::AudioFormatReader> createReader(const juce::File& file);
+
+    // A writer for file in the format its extension names, matching source's
+    // rate, channels and metadata. bitDepth 0 keeps source's depth where the
+    // format has it. Returns nullptr with the reason in error on failure.
+    // writeFailed, if given, is set by any background write that fails,
+    // including the ones still queued when the writer is deleted
+    std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file, const juce::AudioFormatReader& source,
+                                                          int bitDepth, juce::String& error,
+                                                          std::atomic<bool>* writeFailed = nullptr);
+
+private:
+    // Shared block loop; writeBlock(startSample, numSamples) writes that part
+    // of buffer and returns false on failure
+    template <typename WriteBlock>
+    juce::Result renderSamples(juce::AudioFormatReader& reader, juce::int64 start, juce::int64 end,
+                               juce::int64 preRollSamples, WriteBlock&& writeBlock);
+
+    const RenderPreset& preset;
+    juce::AudioFormatManager formatManager;
+    Compressor<float> compressor;
+    juce::AudioBuffer<float> buffer;
+    std::vector<const float*> channelPointers;
+
+    juce::TimeSliceThread* backgroundThread = nullptr;
+    int readAheadSamples = 0;
+    int writeBehindSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(FileRenderer)
+};
@@ -0,0 +1,328 @@
+#include <juce_core/juce_core.h>
+#include <iostream>
+#include "BatchRenderer.h"
+#include "RenderPreset.h"
+#include "SegmentRenderer.h"
+#include "StreamRenderer.h"
+
+#if JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <io.h>
+#endif
+
+namespace
+{
+    // Input files, with folders expanded to the audio files directly inside them
+    juce::Array<juce::File> collectInputs(const juce::ArgumentList& args, juce::AudioFormatManager& formatManager)
+    {
+        juce::Array<juce::File> inputs;
+        for (const auto& argument : args.arguments)
+        {
+            if (argument.isOption())
+                juce::ConsoleApplication::fail("Unknown option " + argument.text);
+
+            const auto file = argument.resolveAsFile();
+            if (file.isDirectory())
+                inputs.addArray(file.findChildFiles(juce::File::findFiles, false, formatManager.getWildcardForAllFormats()));
+            else if (file.existsAsFile())
+                inputs.add(file);
+            else
+                juce::ConsoleApplication::fail("Input not found: " + file.getFullPathName());
+        }
+
+        if (inputs.isEmpty())
+            juce::ConsoleApplication::fail("No input files");
+
+        return inputs;
+    }
+
+    juce::String formatMultiple(double multiple)
+    {
+        return juce::String(multiple, 1) + "x realtime";
+    }
+
+    juce::String formatMegabytes(juce::int64 bytes)
+    {
+        return juce::String(static_cast<double>(bytes) / (1 << 20), 1) + " MB";
+    }
+
+    // The most channels any of the inputs has; unreadable files are left to
+    // fail when they are rendered
+    int getMaxNumChannels(const juce::Array<juce::File>& inputs, juce::AudioFormatManager& formatManager)
+    {
+        int maxNumChannels = 1;
+        for (const auto& input : inputs)
+            if (std::unique_ptr<juce::AudioFormatReader> reader { formatManager.createReaderFor(input) })
+                maxNumChannels = juce::jmax(maxNumChannels, static_cast<int>(reader->numChannels));
+
+        return maxNumChannels;
+    }
+
+    // The renderer's buffers for the widest input, in bytes. Fails if they
+    // would take more than half the machine's memory
+    juce::int64 checkMemoryBound(const BatchRenderer& renderer, int numChannels)
+    {
+        const auto memoryBound = renderer.getMemoryBound(numChannels);
+        const auto memorySize = static_cast<juce::int64>(juce::SystemStats::getMemorySizeInMegabytes()) << 20;
+
+        if (memorySize > 0 && memoryBound > memorySize / 2)
+            juce::ConsoleApplication::fail(juce::String(renderer.getNumWorkers()) + " jobs on " + juce::String(numChannels)
+                                           + "-channel files need up to " + formatMegabytes(memoryBound) + " of buffers, more than half of the "
+                                           + formatMegabytes(memorySize) + " of memory; use fewer --jobs");
+
+        return memoryBound;
+    }
+
+    void printFileReport(const BatchRenderer::FileReport& report)
+    {
+        if (report.result.failed())
+        {
+            std::cerr << report.result.getErrorMessage() << std::endl;
+            return;
+        }
+
+        std::cout << report.input.getFileName() << " -> " << report.output.getFullPathName()
+                  << " (" << juce::String(report.stats.audioSeconds, 1) << " s in " << juce::String(report.stats.renderSeconds, 2)
+                  << " s, " << formatMultiple(report.stats.getRealtimeMultiple()) << ", worker " << report.worker << ")" << std::endl;
+    }
+
+    void printSummary(const BatchRenderer::Summary& summary, juce::int64 memoryBound)
+    {
+        const auto numRendered = static_cast<int>(summary.files.size()) - summary.numFailed;
+        std::cout << numRendered << " files, " << juce::String(summary.audioSeconds, 1) << " s of audio in "
+                  << juce::String(summary.wallSeconds, 2) << " s on " << summary.numWorkers << " workers: "
+                  << formatMultiple(summary.getRealtimeMultiple()) << " ("
+                  << formatMultiple(summary.getRealtimeMultiple() / summary.numWorkers) << " per worker), buffers at most "
+                  << formatMegabytes(memoryBound) << std::endl;
+    }
+
+    // One file cut into segments rendered in parallel, optionally checked
+    // against a serial render
+    void renderSegmented(const RenderPreset& preset, const SegmentRenderer::Options& options, const juce::File& input, const juce::File& output)
+    {
+        SegmentRenderer renderer(preset, options);
+        SegmentRenderer::Report report;
+
+        if (const auto result = renderer.render(input, output, report); result.failed())
+            juce::ConsoleApplication::fail(result.getErrorMessage());
+
+        std::cout << input.getFileName() << " -> " << output.getFullPathName()
+                  << " (" << juce::String(report.stats.audioSeconds, 1) << " s in " << juce::String(report.stats.renderSeconds, 2)
+                  << " s, " << formatMultiple(report.stats.getRealtimeMultiple()) << ", " << report.numSegments << " segments, "
+                  << juce::String(renderer.getPreRollSeconds(), 2) << " s pre-roll)" << std::endl;
+
+        if (! report.verified)
+            return;
+
+        const auto serialMultiple = report.serialSeconds > 0.0 ? report.stats.audioSeconds / report.serialSeconds : 0.0;
+        std::cout << "serial render: " << juce::String(report.serialSeconds, 2) << " s, " << formatMultiple(serialMultiple)
+                  << "; max difference " << juce::String(report.maxDifferenceDb, 1) << " dBFS, tolerance "
+                  << juce::String(options.toleranceDb, 1) << " dBFS" << std::endl;
+
+        if (! report.isWithinTolerance())
+            juce::ConsoleApplication::fail("Segmented render differs beyond the tolerance from sample "
+                                           + juce::String(report.firstMismatch) + " on; "
+                                           + output.getFullPathName() + " was not written");
+    }
+
+    // Renders the whole batch with 1, 2, 4, ... workers up to all of them, into
+    // a scratch folder, and prints how close the throughput gets to linear
+    void runBenchmark(BatchRenderer& renderer, const juce::Array<juce::File>& inputs)
+    {
+        const auto scratch = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                 .getNonexistentChildFile("SondyCompRenderBenchmark", "");
+        if (! scratch.createDirectory())
+            juce::ConsoleApplication::fail("Cannot create " + scratch.getFullPathName());
+
+        std::vector<BatchRenderer::Job> jobs;
+        for (int index = 0; index < inputs.size(); ++index)
+            jobs.push_back({ inputs[index], scratch.getChildFile(juce::String(index) + ".wav") });
+
+        std::vector<int> workerCounts;
+        for (int count = 1; count < renderer.getNumWorkers(); count *= 2)
+            workerCounts.push_back(count);
+        workerCounts.push_back(renderer.getNumWorkers());
+
+        std::cout << "workers  realtime     speedup  efficiency" << std::endl;
+
+        double singleWorkerMultiple = 0.0;
+        for (auto count : workerCounts)
+        {
+            const auto summary = renderer.run(jobs, nullptr, count);
+            if (summary.numFailed > 0)
+            {
+                scratch.deleteRecursively();
+                juce::ConsoleApplication::fail(juce::String(summary.numFailed) + " files failed during the benchmark");
+            }
+
+            const auto multiple = summary.getRealtimeMultiple();
+            if (count == 1)
+                singleWorkerMultiple = multiple;
+
+            const auto speedup = singleWorkerMultiple > 0.0 ? multiple / singleWorkerMultiple : 0.0;
+            std::cout << juce::String(count).paddedLeft(' ', 7)
+                      << juce::String(multiple, 1).paddedLeft(' ', 10) << "x"
+                      << juce::String(speedup, 2).paddedLeft(' ', 11)
+                      << (juce::String(100.0 * speedup / count, 1) + "%").paddedLeft(' ', 12) << std::endl;
+        }
+
+        scratch.deleteRecursively();
+    }
+
+    RenderPreset loadPreset(juce::ArgumentList& args)
+    {
+        args.failIfOptionIsMissing("--preset");
+        const auto presetFile = args.getExistingFileForOptionAndRemove("--preset");
+
+        RenderPreset preset;
+        if (const auto result = RenderPreset::loadFromFile(presetFile, preset); result.failed())
+            juce::ConsoleApplication::fail(result.getErrorMessage());
+
+        return preset;
+    }
+
+    // Raw PCM from stdin to stdout. Nothing but audio goes to stdout; errors
+    // and --stats go to stderr
+    void renderStream(juce::ArgumentList args)
+    {
+        args.removeOptionIfFound("--stream");
+        const auto preset = loadPreset(args);
+
+        args.failIfOptionIsMissing("--rate");
+        args.failIfOptionIsMissing("--channels");
+        const auto sampleRate = args.removeValueForOption("--rate").getDoubleValue();
+        const auto numChannels = args.removeValueForOption("--channels").getIntValue();
+        const auto formatName = args.containsOption("--pcm") ? args.removeValueForOption("--pcm") : juce::String("f32");
+        const bool printStats = args.removeOptionIfFound("--stats");
+
+        PcmConversion::Format format;
+        if (! PcmConversion::parse(formatName, format))
+            juce::ConsoleApplication::fail("Unknown PCM format " + formatName + " (s16, s24, s32 or f32)");
+
+        if (sampleRate <= 0.0 || numChannels < 1)
+            juce::ConsoleApplication::fail("--rate and --channels need positive values");
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail("Unexpected argument " + args[0].text);
+
+       #if JUCE_WINDOWS
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+       #endif
+
+        StreamRenderer renderer(preset, format, sampleRate, numChannels);
+        FileRenderer::Stats stats;
+
+        if (const auto result = renderer.run(stdin, stdout, &stats); result.failed())
+            juce::ConsoleApplication::fail(result.getErrorMessage());
+
+        if (printStats)
+            std::cerr << juce::String(stats.audioSeconds, 1) << " s in " << juce::String(stats.renderSeconds, 2)
+                      << " s, " << formatMultiple(stats.getRealtimeMultiple()) << std::endl;
+    }
+
+    void renderFiles(juce::ArgumentList args)
+    {
+        const auto preset = loadPreset(args);
+
+        // Outputs go next to the inputs unless a folder is given. With no folder
+        // and no suffix the input would be overwritten, so a suffix is added
+        const auto outputFolder = args.containsOption("--output") ? args.getFileForOptionAndRemove("--output") : juce::File();
+        auto suffix = args.removeValueForOption("--suffix");
+        auto extension = args.removeValueForOption("--format");
+
+        BatchRenderer::Options options;
+        if (args.containsOption("--jobs"))
+            options.numWorkers = juce::jmax(1, args.removeValueForOption("--jobs").getIntValue());
+
+        const bool benchmark = args.removeOptionIfFound("--benchmark");
+
+        SegmentRenderer::Options segmentOptions;
+        const bool segmented = args.containsOption("--segments");
+        if (segmented)
+            segmentOptions.numSegments = juce::jmax(1, args.removeValueForOption("--segments").getIntValue());
+        if (args.containsOption("--pre-roll"))
+            segmentOptions.preRollSeconds = juce::jmax(0.0, args.removeValueForOption("--pre-roll").getDoubleValue());
+        if (args.containsOption("--tolerance"))
+            segmentOptions.toleranceDb = args.removeValueForOption("--tolerance").getDoubleValue();
+        segmentOptions.verify = args.removeOptionIfFound("--verify");
+
+        if (outputFolder == juce::File() && suffix.isEmpty())
+            suffix = "_comp";
+
+        if (extension.isNotEmpty() && ! extension.startsWithChar('.'))
+            extension = "." + extension;
+
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+        const auto inputs = collectInputs(args, formatManager);
+
+        if (segmented && (benchmark || inputs.size() != 1))
+            juce::ConsoleApplication::fail("--segments renders a single input file");
+
+        if (benchmark)
+        {
+            BatchRenderer renderer(preset, options);
+            checkMemoryBound(renderer, getMaxNumChannels(inputs, formatManager));
+            runBenchmark(renderer, inputs);
+            return;
+        }
+
+        if (outputFolder != juce::File() && ! outputFolder.createDirectory())
+            juce::ConsoleApplication::fail("Cannot create " + outputFolder.getFullPathName());
+
+        std::vector<BatchRenderer::Job> jobs;
+        for (const auto& input : inputs)
+        {
+            const auto folder = outputFolder != juce::File() ? outputFolder : input.getParentDirectory();
+            jobs.push_back({ input, folder.getChildFile(input.getFileNameWithoutExtension() + suffix
+                                                        + (extension.isNotEmpty() ? extension : input.getFileExtension())) });
+        }
+
+        if (segmented)
+        {
+            renderSegmented(preset, segmentOptions, jobs.front().input, jobs.front().output);
+            return;
+        }
+
+        BatchRenderer renderer(preset, options);
+        const auto memoryBound = checkMemoryBound(renderer, getMaxNumChannels(inputs, formatManager));
+        const auto summary = renderer.run(jobs, printFileReport);
+        printSummary(summary, memoryBound);
+
+        if (summary.numFailed > 0)
+            juce::ConsoleApplication::fail(juce::String(summary.numFailed) + " of " + juce::String(inputs.size()) + " files failed");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+
+    app.addHelpCommand("--help|-h", "SondyComp offline renderer", false);
+    app.addDefaultCommand({ "",
+                            "--preset <file.json> [--output <folder>] [--suffix <text>] [--format wav|aiff|flac] [--jobs <n>] [--benchmark]\n"
+                            "    [--segments <n> [--pre-roll <seconds>] [--verify [--tolerance <dBFS>]]] <files or folders...>",
+                            "Renders audio files through the compressor",
+                            "Reads WAV, AIFF and FLAC files and writes each one compressed with the settings and curves\n"
+                            "from the preset, latency-compensated and at the input's bit depth where the output format allows.\n"
+                            "Outputs go next to the inputs with \"_comp\" added unless --output or --suffix is given.\n"
+                            "Files are rendered in parallel on --jobs workers (default: one per core). The render fails up front\n"
+                            "if the workers' buffers for the widest input would take more than half the memory.\n"
+                            "--benchmark renders the inputs with 1, 2, 4, ... workers into a scratch folder and reports the scaling.\n"
+                            "--segments renders a single file as n segments in parallel, each starting --pre-roll seconds early\n"
+                            "(default: four times attack plus release, at least 1 s) so the compressor has settled, and stitches\n"
+                            "them together. --verify also renders the file serially and fails if any sample differs by more\n"
+                            "than --tolerance (default: -90 dBFS), without replacing the output.",
+                            [](const juce::ArgumentList& args) { renderFiles(args); } });
+
+    app.addCommand({ "--stream",
+                     "--stream --preset <file.json> --rate <hz> --channels <n> [--pcm s16|s24|s32|f32] [--stats]",
+                     "Filters raw PCM from stdin to stdout",
+                     "Reads raw interleaved little-endian PCM from stdin until it ends and writes it compressed, in the\n"
+                     "same format and latency-compensated, to stdout (--pcm defaults to f32), for ffmpeg and sox pipelines.\n"
+                     "Memory use is constant. --stats prints the realtime multiple to stderr.",
+                     [](const juce::ArgumentList& args) { renderStream(args); } });
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//==============================================================================
+// Raw little-endian PCM, as ffmpeg and sox pipe it, converted straight between
+// interleaved bytes and the compressor's planar float buffers. Integers are
+// scaled to -1..1 on the way in and clipped on the way out; float passes
+// through unclipped.
+namespace PcmConversion
+{
+    enum class Format
+    {
+        s16,
+        s24,
+        s32,
+        f32
+    };
+
+    // Parses the ffmpeg-style names s16, s24, s32 and f32 (an "le" suffix is accepted)
+    inline bool parse(juce::String name, Format& format)
+    {
+        name = name.trim().toLowerCase();
+        if (name.endsWith("le"))
+            name = name.dropLastCharacters(2);
+
+        if (name == "s16")      format = Format::s16;
+        else if (name == "s24") format = Format::s24;
+        else if (name == "s32") format = Format::s32;
+        else if (name == "f32") format = Format::f32;
+        else                    return false;
+
+        return true;
+    }
+
+    inline int getBytesPerSample(Format format)
+    {
+        switch (format)
+        {
+            case Format::s16: return 2;
+            case Format::s24: return 3;
+            case Format::s32:
+            case Format::f32: return 4;
+        }
+
+        return 4;
+    }
+
+    //==============================================================================
+    struct Int16
+    {
+        static constexpr int numBytes = 2;
+
+        static float read(const uint8_t* bytes)
+        {
+            const auto value = static_cast<int16_t>(static_cast<uint16_t>(bytes[0] | (bytes[1] << 8)));
+            return static_cast<float>(value) * (1.0f / 32768.0f);
+        }
+
+        static void write(float sample, uint8_t* bytes)
+        {
+            const auto value = juce::jmin(32767, juce::roundToInt(juce::jlimit(-1.0f, 1.0f, sample) * 32768.0f));
+            bytes[0] = static_cast<uint8_t>(value);
+            bytes[1] = static_cast<uint8_t>(value >> 8);
+        }
+    };
+
+    struct Int24
+    {
+        static constexpr int numBytes = 3;
+
+        static float read(const uint8_t* bytes)
+        {
+            // Sign-extended from bit 23 by way of the top byte
+            const auto raw = static_cast<uint32_t>(bytes[0] << 8 | bytes[1] << 16 | static_cast<uint32_t>(bytes[2]) << 24);
+            return static_cast<float>(static_cast<int32_t>(raw) >> 8) * (1.0f / 8388608.0f);
+        }
+
+        static void write(float sample, uint8_t* bytes)
+        {
+            const auto value = juce::jmin(8388607, juce::roundToInt(juce::jlimit(-1.0f, 1.0f, sample) * 8388608.0f));
+            bytes[0] = static_cast<uint8_t>(value);
+            bytes[1] = static_cast<uint8_t>(value >> 8);
+            bytes[2] = static_cast<uint8_t>(value >> 16);
+        }
+    };
+
+    struct Int32
+    {
+        static constexpr int numBytes = 4;
+
+        static float read(const uint8_t* bytes)
+        {
+            const auto raw = static_cast<uint32_t>(bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24);
+            return static_cast<float>(static_cast<int32_t>(raw)) * (1.0f / 2147483648.0f);
+        }
+
+        static void write(float sample, uint8_t* bytes)
+        {
+            // Scaled in double: full scale doesn't fit a float-to-int conversion
+            const auto value = static_cast<uint32_t>(static_cast<int32_t>(juce::jlimit(-2147483648.0, 2147483647.0,
+                                                                                        std::round(static_cast<double>(sample) * 2147483648.0))));
+            bytes[0] = static_cast<uint8_t>(value);
+            bytes[1] = static_cast<uint8_t>(value >> 8);
+            bytes[2] = static_cast<uint8_t>(value >> 16);
+            bytes[3] = static_cast<uint8_t>(value >> 24);
+        }
+    };
+
+    struct Float32
+    {
+        static constexpr int numBytes = 4;
+
+        static float read(const uint8_t* bytes)
+        {
+            const auto raw = static_cast<uint32_t>(bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24);
+            float sample;
+            std::memcpy(&sample, &raw, sizeof(sample));
+            return sample;
+        }
+
+        static void write(float sample, uint8_t* bytes)
+        {
+            uint32_t raw;
+            std::memcpy(&raw, &sample, sizeof(raw));
+            bytes[0] = static_cast<uint8_t>(raw);
+            bytes[1] = static_cast<uint8_t>(raw >> 8);
+            bytes[2] = static_cast<uint8_t>(raw >> 16);
+            bytes[3] = static_cast<uint8_t>(raw >> 24);
+        }
+    };
+
+    //==============================================================================
+    // numFrames interleaved frames from source into the first numFrames
+    // samples of every channel of dest
+    template <typename Sample>
+    void deinterleave(const uint8_t* source, juce::AudioBuffer<float>& dest, int numFrames)
+    {
+        const int numChannels = dest.getNumChannels();
+        const int stride = numChannels * Sample::numBytes;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* in = source + channel * Sample::numBytes;
+            auto* out = dest.getWritePointer(channel);
+
+            for (int frame = 0; frame < numFrames; ++frame, in += stride)
+                out[frame] = Sample::read(in);
+        }
+    }
+
+    // numFrames samples of every channel of source, from startSample, into
+    // interleaved frames at dest
+    template <typename Sample>
+    void interleave(const juce::AudioBuffer<float>& source, int startSample, uint8_t* dest, int numFrames)
+    {
+        const int numChannels = source.getNumChannels();
+        const int stride = numChannels * Sample::numBytes;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* in = source.getReadPointer(channel, startSample);
+            auto* out = dest + channel * Sample::numBytes;
+
+            for (int frame = 0; frame < numFrames; ++frame, out += stride)
+                Sample::write(in[frame], out);
+        }
+    }
+
+    inline void deinterleave(Format format, const uint8_t* source, juce::AudioBuffer<float>& dest, int numFrames)
+    {
+        switch (format)
+        {
+            case Format::s16: deinterleave<Int16>(source, dest, numFrames); break;
+            case Format::s24: deinterleave<Int24>(source, dest, numFrames); break;
+            case Format::s32: deinterleave<Int32>(source, dest, numFrames); break;
+            case Format::f32: deinterleave<Float32>(source, dest, numFrames); break;
+        }
+    }
+
+    inline void interleave(Format format, const juce::AudioBuffer<float>& source, int startSample, uint8_t* dest, int numFrames)
+    {
+        switch (format)
+        {
+            case Format::s16: interleave<Int16>(source, startSample, dest, numFrames); break;
+            case Format::s24: interleave<Int24>(source, startSample, dest, numFrames); break;
+            case Format::s32: interleave<Int32>(source, startSample, dest, numFrames); break;
+            case Format::f32: interleave<Float32>(source, startSample, dest, numFrames); break;
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include "RenderPreset.h"
+#include <limits>
+
+namespace
+{
+    // Reads a number field if present
+    juce::Result readNumber(const juce::var& json, const char* key, float& value)
+    {
+        const auto& field = json[key];
+        if (field.isVoid())
+            return juce::Result::ok();
+
+        if (! (field.isInt() || field.isInt64() || field.isDouble()))
+            return juce::Result::fail(juce::String("\"") + key + "\" must be a number");
+
+        value = static_cast<float>(static_cast<double>(field));
+        return juce::Result::ok();
+    }
+
+    // Reads a choice field, given either by name (case-insensitive) or by index
+    template <typename EnumType>
+    juce::Result readChoice(const juce::var& json, const char* key, const juce::StringArray& names, EnumType& value)
+    {
+        const auto& field = json[key];
+        if (field.isVoid())
+            return juce::Result::ok();
+
+        int index = field.isString() ? names.indexOf(field.toString().trim(), true) : static_cast<int>(field);
+        if (! field.isString() && ! (field.isInt() || field.isInt64()))
+            index = -1;
+
+        if (! juce::isPositiveAndBelow(index, names.size()))
+            return juce::Result::fail(juce::String("\"") + key + "\" must be one of: " + names.joinIntoString(", "));
+
+        value = static_cast<EnumType>(index);
+        return juce::Result::ok();
+    }
+
+    // Reads a curve, given as a preset shape name or as EnvelopeCurve::numPoints values in 0..1
+    juce::Result readCurve(const juce::var& json, const char* key, bool isRelease, EnvelopeCurve::Points& points)
+    {
+        const auto& field = json[key];
+        if (field.isVoid())
+            return juce::Result::ok();
+
+        if (field.isString())
+        {
+            for (int shape = 0; shape < CurvePresets::numShapes; ++shape)
+            {
+                if (field.toString().trim().equalsIgnoreCase(CurvePresets::getName(static_cast<CurvePresets::Shape>(shape))))
+                {
+                    points = CurvePresets::make(static_cast<CurvePresets::Shape>(shape), isRelease);
+                    return juce::Result::ok();
+                }
+            }
+
+            return juce::Result::fail(juce::String("\"") + key + "\": unknown curve \"" + field.toString() + "\"");
+        }
+
+        const auto* values = field.getArray();
+        if (values == nullptr || values->size() != EnvelopeCurve::numPoints)
+            return juce::Result::fail(juce::String("\"") + key + "\" must be a curve name or an array of "
+                                      + juce::String(EnvelopeCurve::numPoints) + " numbers");
+
+        for (int i = 0; i < EnvelopeCurve::numPoints; ++i)
+            points[static_cast<size_t>(i)] = juce::jlimit(0.0f, 1.0f, static_cast<float>(static_cast<double>(values->getReference(i))));
+
+        return juce::Result::ok();
+    }
+}
+
+juce::Result RenderPreset::loadFromFile(const juce::File& file, RenderPreset& preset)
+{
+    if (! file.existsAsFile())
+        return juce::Result::fail("Preset not found: " + file.getFullPathName());
+
+    juce::var json;
+    const auto parseResult = juce::JSON::parse(file.loadFileAsString(), json);
+    if (parseResult.failed())
+        return juce::Result::fail(file.getFileName() + ": " + parseResult.getErrorMessage());
+
+    const auto loadResult = preset.loadFromJson(json);
+    if (loadResult.failed())
+        return juce::Result::fail(file.getFileName() + ": " + loadResult.getErrorMessage());
+
+    return juce::Result::ok();
+}
+
+juce::Result RenderPreset::loadFromJson(const juce::var& json)
+{
+    if (! json.isObject())
+        return juce::Result::fail("the preset must be a JSON object");
+
+    // "inf" (or anything starting with it) gives a limiter, as in the plugin
+    if (json["ratio"].isString() && json["ratio"].toString().trim().startsWithIgnoreCase("inf"))
+        ratio = std::numeric_limits<float>::infinity();
+    else if (auto result = readNumber(json, "ratio", ratio); result.failed())
+        return result;
+
+    float oversamplingValue = static_cast<float>(oversampling);
+    float resolutionValue = static_cast<float>(curveResolution);
+
+    const std::pair<const char*, float*> numbers[] = {
+        { "input_gain", &inputGain },
+        { "output_gain", &outputGain },
+        { "threshold", &threshold },
+        { "knee", &knee },
+        { "attack_time", &attackTime },
+        { "release_time", &releaseTime },
+        { "oversampling", &oversamplingValue },
+        { "lookahead", &lookahead },
+        { "key_high_pass", &keyHighPass },
+        { "key_low_pass", &keyLowPass },
+        { "curve_resolution", &resolutionValue }
+    };
+
+    for (const auto& [key, value] : numbers)
+        if (auto result = readNumber(json, key, *value); result.failed())
+            return result;
+
+    oversampling = juce::jlimit(0, Compressor<float>::maxOversamplingLog2, juce::roundToInt(oversamplingValue));
+    curveResolution = juce::jlimit(EnvelopeCurve::minResolution, EnvelopeCurve::maxResolution, juce::roundToInt(resolutionValue));
+
+    if (ratio < 1.0f)
+        return juce::Result::fail("\"ratio\" must be 1 or more");
+
+    if (attackTime <= 0.0f || releaseTime <= 0.0f)
+        return juce::Result::fail("\"attack_time\" and \"release_time\" must be above 0");
+
+    // As in the plugin, the eco envelope is the detector choice after the three modes
+    int detectorChoice = json["detector_mode"].isVoid() ? -1 : 0;
+    if (auto result = readChoice(json, "detector_mode", { "peak", "rms", "peak/rms", "rms eco" }, detectorChoice); result.failed())
+        return result;
+
+    if (detectorChoice >= 0)
+    {
+        const bool rmsEco = detectorChoice == 3;
+        detectorMode = rmsEco ? Compressor<float>::DetectorMode::rms : static_cast<Compressor<float>::DetectorMode>(detectorChoice);
+        envelopeMode = rmsEco ? Compressor<float>::EnvelopeMode::eco : Compressor<float>::EnvelopeMode::perSample;
+    }
+
+    if (auto result = readChoice(json, "curve_interpolation", { "linear", "cubic" }, curveInterpolation); result.failed())
+        return result;
+
+    if (auto result = readChoice(json, "channel_link", { "linked", "lfe independent", "by position", "unlinked" }, channelLink); result.failed())
+        return result;
+
+    if (auto result = readCurve(json, "attack_curve", false, attackCurve); result.failed())
+        return result;
+
+    return readCurve(json, "release_curve", true, releaseCurve);
+}
+
+void RenderPreset::applyTo(Compressor<float>& compressor) const
+{
+    compressor.setInputGain(inputGain);
+    compressor.setOutputGain(outputGain);
+    compressor.setThreshold(threshold);
+    compressor.setKnee(knee);
+    compressor.setRatio(ratio);
+    compressor.setAttackTime(attackTime);
+    compressor.setReleaseTime(releaseTime);
+    compressor.setOversamplingFactor(oversampling);
+    compressor.setLookahead(lookahead);
+    compressor.setDetectorMode(detectorMode);
+    compressor.setEnvelopeMode(envelopeMode);
+    compressor.setKeyHighPass(keyHighPass);
+    compressor.setKeyLowPass(keyLowPass);
+
+    compressor.setWavetableResolution(curveResolution);
+    compressor.setWavetableInterpolation(curveInterpolation);
+    compressor.setAttackWavetable(attackCurve);
+    compressor.setReleaseWavetable(releaseCurve);
+}
+
+void RenderPreset::applyLinkGroups(Compressor<float>& compressor, int numChannels) const
+{
+    // Files carry no layout, so the channel count picks JUCE's usual one (6 = 5.1 etc.)
+    const auto groups = ChannelLinking::makeGroups(juce::AudioChannelSet::canonicalChannelSet(numChannels), channelLink);
+    compressor.setLinkGroups(groups.data(), static_cast<int>(groups.size()));
+}
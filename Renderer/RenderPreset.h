@@ -0,0 +1,56 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "Compressor.h"
+#include "ChannelLinking.h"
+#include "CurvePresets.h"
+#include "KeyFilter.h"
+
+//==============================================================================
+// Compressor settings for offline rendering, loaded from a JSON preset file.
+//
+// Keys use the plugin's parameter IDs; anything left out keeps the plugin's
+// default. Curves are either a preset shape name or an array of 256 points:
+//
+//     {
+//         "threshold": -18, "knee": 6, "ratio": 4,
+//         "attack_time": 0.01, "release_time": 0.25,
+//         "detector_mode": "rms", "channel_link": "lfe independent",
+//         "attack_curve": "s-curve",
+//         "release_curve": [1.0, 0.99, ...]
+//     }
+struct RenderPreset
+{
+    float inputGain = 0.0f;         // dB
+    float outputGain = 0.0f;        // dB
+    float threshold = -12.0f;       // dB
+    float knee = 6.0f;              // dB
+    float ratio = 4.0f;             // x:1; "inf" in the file for a limiter
+    float attackTime = 0.1f;        // seconds
+    float releaseTime = 0.3f;       // seconds
+    int oversampling = 0;           // 0 = off, 1 = 2x, 2 = 4x, 3 = 8x
+    float lookahead = 0.0f;         // ms
+    float keyHighPass = KeyFilter<float>::minHighPassHz;
+    float keyLowPass = KeyFilter<float>::maxLowPassHz;
+
+    Compressor<float>::DetectorMode detectorMode = Compressor<float>::DetectorMode::peak;
+    Compressor<float>::EnvelopeMode envelopeMode = Compressor<float>::EnvelopeMode::perSample;
+    EnvelopeCurve::Interpolation curveInterpolation = EnvelopeCurve::Interpolation::linear;
+    int curveResolution = EnvelopeCurve::defaultResolution;
+    ChannelLinking::Mode channelLink = ChannelLinking::Mode::linked;
+
+    // Same as a freshly constructed Compressor
+    EnvelopeCurve::Points attackCurve = CurvePresets::make(CurvePresets::Shape::linear, false);
+    EnvelopeCurve::Points releaseCurve = CurvePresets::make(CurvePresets::Shape::linear, true);
+
+    // Fills preset from a JSON file; fields missing from the file are left untouched
+    static juce::Result loadFromFile(const juce::File& file, RenderPreset& preset);
+    juce::Result loadFromJson(const juce::var& json);
+
+    // Settings and curves. Call before compressor.prepare(), so the parameter
+    // ramps start at their targets instead of sliding in from the defaults
+    void applyTo(Compressor<float>& compressor) const;
+
+    // Link groups for a file with numChannels channels. Call after compressor.prepare()
+    void applyLinkGroups(Compressor<float>& compressor, int numChannels) const;
+};
@@ -0,0 +1,229 @@
+#include "SegmentRenderer.h"
+#include <thread>
+
+SegmentRenderer::SegmentRenderer(const RenderPreset& presetToUse, const Options& newOptions)
+    : preset(presetToUse), options(newOptions)
+{
+    options.numSegments = juce::jmax(1, options.numSegments);
+
+    for (int segment = 0; segment < options.numSegments; ++segment)
+        renderers.push_back(std::make_unique<FileRenderer>(preset));
+}
+
+double SegmentRenderer::getPreRollSeconds() const
+{
+    if (options.preRollSeconds >= 0.0)
+        return options.preRollSeconds;
+
+    return juce::jmax(1.0, 4.0 * static_cast<double>(preset.attackTime + preset.releaseTime));
+}
+
+juce::Result SegmentRenderer::render(const juce::File& input, const juce::File& output, Report& report)
+{
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    auto source = renderers.front()->createReader(input);
+    if (source == nullptr)
+        return juce::Result::fail("Cannot read " + input.getFullPathName());
+
+    report = {};
+    report.preRollSamples = juce::roundToInt(getPreRollSeconds() * source->sampleRate);
+
+    std::vector<std::unique_ptr<juce::TemporaryFile>> segmentFiles;
+    if (const auto result = renderSegments(input, output, *source, report.preRollSamples, segmentFiles); result.failed())
+        return result;
+
+    report.numSegments = static_cast<int>(segmentFiles.size());
+
+    // Written next to the target and moved over it once complete and, with
+    // verification on, within the tolerance, so a failed or mismatching render
+    // never replaces the file
+    juce::TemporaryFile temporary(output);
+    {
+        juce::String error;
+        std::atomic<bool> writeFailed { false };
+        auto writer = renderers.front()->createWriter(temporary.getFile(), *source, 0, error, &writeFailed);
+        if (writer == nullptr)
+            return juce::Result::fail("Cannot write " + output.getFullPathName() + ": " + error);
+
+        const auto result = stitch(segmentFiles, *writer);
+        writer.reset();
+
+        if (result.failed() || writeFailed)
+            return juce::Result::fail((result.failed() ? result.getErrorMessage() : juce::String("Write error"))
+                                      + " stitching " + output.getFullPathName());
+    }
+
+    report.stats.audioSeconds = static_cast<double>(source->lengthInSamples) / source->sampleRate;
+    report.stats.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+    if (options.verify)
+    {
+        if (const auto result = verify(input, temporary.getFile(), output, report); result.failed())
+            return result;
+
+        if (! report.isWithinTolerance())
+            return juce::Result::ok();
+    }
+
+    if (! temporary.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Cannot replace " + output.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+juce::Result SegmentRenderer::renderSegments(const juce::File& input, const juce::File& target, juce::AudioFormatReader& source,
+                                             juce::int64 preRollSamples, std::vector<std::unique_ptr<juce::TemporaryFile>>& segmentFiles)
+{
+    // Boundaries on the block grid, so every segment processes the same
+    // blocks as a whole-file render; short files get fewer segments
+    const auto length = source.lengthInSamples;
+    const auto numBlocks = (length + FileRenderer::blockSize - 1) / FileRenderer::blockSize;
+    const auto numSegments = static_cast<int>(juce::jlimit(static_cast<juce::int64>(1), static_cast<juce::int64>(getNumSegments()), numBlocks));
+
+    std::vector<juce::int64> boundaries;
+    for (int segment = 0; segment <= numSegments; ++segment)
+        boundaries.push_back(juce::jmin(length, numBlocks * segment / numSegments * FileRenderer::blockSize));
+
+    std::vector<juce::Result> results(static_cast<size_t>(numSegments), juce::Result::ok());
+    for (int segment = 0; segment < numSegments; ++segment)
+        segmentFiles.push_back(std::make_unique<juce::TemporaryFile>(target.withFileExtension(".wav")));
+
+    auto renderSegment = [&](int segment)
+    {
+        auto& renderer = *renderers[static_cast<size_t>(segment)];
+        auto& result = results[static_cast<size_t>(segment)];
+
+        auto reader = renderer.createReader(input);
+        if (reader == nullptr)
+        {
+            result = juce::Result::fail("Cannot read " + input.getFullPathName());
+            return;
+        }
+
+        // 32-bit WAV is float, so nothing is quantized before stitching
+        juce::String error;
+        std::atomic<bool> writeFailed { false };
+        auto writer = renderer.createWriter(segmentFiles[static_cast<size_t>(segment)]->getFile(), *reader, 32, error, &writeFailed);
+        if (writer == nullptr)
+        {
+            result = juce::Result::fail("Cannot write a segment of " + target.getFullPathName() + ": " + error);
+            return;
+        }
+
+        result = renderer.renderRange(*reader, *writer, boundaries[static_cast<size_t>(segment)],
+                                      boundaries[static_cast<size_t>(segment) + 1], preRollSamples);
+        writer.reset();
+
+        if (result.failed())
+            result = juce::Result::fail(result.getErrorMessage() + " rendering " + input.getFullPathName());
+        else if (writeFailed)
+            result = juce::Result::fail("Write error in a segment of " + target.getFullPathName());
+    };
+
+    std::vector<std::thread> threads;
+    for (int segment = 1; segment < numSegments; ++segment)
+        threads.emplace_back(renderSegment, segment);
+
+    // The calling thread renders the first segment
+    renderSegment(0);
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto& result : results)
+        if (result.failed())
+            return result;
+
+    return juce::Result::ok();
+}
+
+juce::Result SegmentRenderer::stitch(const std::vector<std::unique_ptr<juce::TemporaryFile>>& segmentFiles,
+                                     juce::AudioFormatWriter& writer)
+{
+    for (const auto& segmentFile : segmentFiles)
+    {
+        auto reader = renderers.front()->createReader(segmentFile->getFile());
+        if (reader == nullptr)
+            return juce::Result::fail("Read error");
+
+        if (! writer.writeFromAudioReader(*reader, 0, -1))
+            return juce::Result::fail("Write error");
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result SegmentRenderer::verify(const juce::File& input, const juce::File& stitched, const juce::File& target, Report& report)
+{
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    auto& renderer = *renderers.front();
+
+    // The reference, rendered serially in the same format and bit depth as the
+    // stitched file, so both are quantized the same way
+    juce::TemporaryFile serialFile(target);
+    {
+        auto reader = renderer.createReader(input);
+        if (reader == nullptr)
+            return juce::Result::fail("Cannot read " + input.getFullPathName());
+
+        juce::String error;
+        std::atomic<bool> writeFailed { false };
+        auto writer = renderer.createWriter(serialFile.getFile(), *reader, 0, error, &writeFailed);
+        if (writer == nullptr)
+            return juce::Result::fail("Cannot write the serial render of " + target.getFullPathName() + ": " + error);
+
+        const auto result = renderer.renderRange(*reader, *writer, 0, reader->lengthInSamples, 0);
+        writer.reset();
+
+        if (result.failed() || writeFailed)
+            return juce::Result::fail((result.failed() ? result.getErrorMessage() : juce::String("Write error"))
+                                      + " rendering " + input.getFullPathName() + " serially");
+    }
+
+    report.serialSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+    auto serial = renderer.createReader(serialFile.getFile());
+    auto segmented = renderer.createReader(stitched);
+    if (serial == nullptr || segmented == nullptr)
+        return juce::Result::fail("Cannot read the renders of " + target.getFullPathName() + " to compare");
+
+    const auto numChannels = static_cast<int>(serial->numChannels);
+    const auto length = juce::jmin(serial->lengthInSamples, segmented->lengthInSamples);
+    const auto tolerance = juce::Decibels::decibelsToGain(static_cast<float>(options.toleranceDb), -1000.0f);
+
+    juce::AudioBuffer<float> expected(numChannels, FileRenderer::blockSize);
+    juce::AudioBuffer<float> actual(numChannels, FileRenderer::blockSize);
+    float maxDifference = 0.0f;
+
+    if (serial->lengthInSamples != segmented->lengthInSamples)
+        report.firstMismatch = length;
+
+    for (juce::int64 position = 0; position < length; position += FileRenderer::blockSize)
+    {
+        const auto numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(FileRenderer::blockSize), length - position));
+        if (! segmented->read(&actual, 0, numSamples, position, true, true)
+            || ! serial->read(&expected, 0, numSamples, position, true, true))
+            return juce::Result::fail("Read error verifying " + target.getFullPathName());
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* a = actual.getReadPointer(channel);
+            const auto* e = expected.getReadPointer(channel);
+
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                const auto difference = std::abs(a[sample] - e[sample]);
+                maxDifference = juce::jmax(maxDifference, difference);
+
+                if (difference > tolerance && (report.firstMismatch < 0 || position + sample < report.firstMismatch))
+                    report.firstMismatch = position + sample;
+            }
+        }
+    }
+
+    report.verified = true;
+    report.maxDifferenceDb = juce::Decibels::gainToDecibels(maxDifference, -100.0f);
+
+    return juce::Result::ok();
+}
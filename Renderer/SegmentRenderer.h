@@ -0,0 +1,74 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "FileRenderer.h"
+#include "RenderPreset.h"
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// Renders one long file on several threads by cutting it into segments.
+//
+// Each segment gets its own FileRenderer and runs a pre-roll of the input
+// before its start through a fresh compressor, so the envelope, detector and
+// lookahead delay have settled by the first sample it keeps. Segments are
+// rendered into 32-bit float WAV files next to the output and stitched in
+// order into the final file, which is only converted to the output bit depth
+// at that point.
+//
+// The result differs from a serial render only by whatever the pre-roll
+// didn't settle. With verification on, the file is also rendered serially,
+// the largest difference to the stitched file is reported against a tolerance,
+// and the output is only replaced when the render is within it.
+class SegmentRenderer
+{
+public:
+    struct Options
+    {
+        int numSegments = juce::SystemStats::getNumCpus();
+        double preRollSeconds = -1.0;   // < 0: automatic, see getPreRollSeconds()
+        bool verify = false;
+        double toleranceDb = -90.0;     // dBFS, about one 16-bit step
+    };
+
+    struct Report
+    {
+        FileRenderer::Stats stats;      // the segmented render and stitching
+        int numSegments = 0;
+        juce::int64 preRollSamples = 0;
+
+        // Only filled in with verification on
+        bool verified = false;
+        double serialSeconds = 0.0;
+        float maxDifferenceDb = -100.0f; // -100 for identical renders
+        juce::int64 firstMismatch = -1;  // first sample beyond the tolerance, -1 if none
+
+        bool isWithinTolerance() const { return firstMismatch < 0; }
+    };
+
+    SegmentRenderer(const RenderPreset& preset, const Options& options);
+
+    int getNumSegments() const { return static_cast<int>(renderers.size()); }
+
+    // The pre-roll given in the options, or four times attack plus release,
+    // and at least a second
+    double getPreRollSeconds() const;
+
+    // Renders input into output, replacing it, as FileRenderer::render() would.
+    // A verified render beyond the tolerance leaves output untouched and
+    // returns ok; check the report
+    juce::Result render(const juce::File& input, const juce::File& output, Report& report);
+
+private:
+    juce::Result renderSegments(const juce::File& input, const juce::File& target, juce::AudioFormatReader& source,
+                                juce::int64 preRollSamples, std::vector<std::unique_ptr<juce::TemporaryFile>>& segmentFiles);
+    juce::Result stitch(const std::vector<std::unique_ptr<juce::TemporaryFile>>& segmentFiles,
+                        juce::AudioFormatWriter& writer);
+    juce::Result verify(const juce::File& input, const juce::File& stitched, const juce::File& target, Report& report);
+
+    const RenderPreset& preset;
+    Options options;
+    std::vector<std::unique_ptr<FileRenderer>> renderers;
+
+    JUCE_DECLARE_NON_COPYABLE(SegmentRenderer)
+};
@@ -0,0 +1,85 @@
+#include "StreamRenderer.h"
+
+StreamRenderer::StreamRenderer(const RenderPreset& presetToUse, PcmConversion::Format newFormat, double newSampleRate, int newNumChannels)
+    : preset(presetToUse),
+      format(newFormat),
+      sampleRate(newSampleRate),
+      numChannels(newNumChannels),
+      frameBytes(newNumChannels * PcmConversion::getBytesPerSample(newFormat))
+{
+    buffer.setSize(numChannels, chunkSize);
+    inputBytes.allocate(static_cast<size_t>(frameBytes * chunkSize), true);
+    outputBytes.allocate(static_cast<size_t>(frameBytes * chunkSize), true);
+}
+
+juce::Result StreamRenderer::run(std::FILE* input, std::FILE* output, FileRenderer::Stats* stats)
+{
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    const juce::ScopedNoDenormals noDenormals;
+
+    preset.applyTo(compressor);
+    compressor.prepare(sampleRate, chunkSize, numChannels, numChannels);
+    preset.applyLinkGroups(compressor, numChannels);
+
+    // Drop the compressor's delay from the start and flush it out at the end
+    const auto latency = compressor.getLatencySamples();
+    int samplesToSkip = latency;
+    int samplesToFlush = latency;
+    juce::int64 framesRead = 0;
+    bool endOfInput = false;
+
+    while (! endOfInput || samplesToFlush > 0)
+    {
+        int numFrames = 0;
+
+        if (! endOfInput)
+        {
+            // fread() only comes back short at the end of the stream; a
+            // trailing partial frame is dropped
+            numFrames = static_cast<int>(std::fread(inputBytes.get(), static_cast<size_t>(frameBytes), chunkSize, input));
+            if (numFrames < chunkSize)
+            {
+                if (std::ferror(input))
+                    return juce::Result::fail("Read error on the input stream");
+
+                endOfInput = true;
+            }
+
+            PcmConversion::deinterleave(format, inputBytes.get(), buffer, numFrames);
+            framesRead += numFrames;
+        }
+
+        if (endOfInput)
+        {
+            const auto numSilent = juce::jmin(samplesToFlush, chunkSize - numFrames);
+            buffer.clear(numFrames, numSilent);
+            numFrames += numSilent;
+            samplesToFlush -= numSilent;
+        }
+
+        if (numFrames == 0)
+            continue;
+
+        compressor.process(juce::dsp::AudioBlock<float>(buffer).getSubBlock(0, static_cast<size_t>(numFrames)));
+
+        const auto skip = juce::jmin(samplesToSkip, numFrames);
+        samplesToSkip -= skip;
+
+        const auto numToWrite = numFrames - skip;
+        PcmConversion::interleave(format, buffer, skip, outputBytes.get(), numToWrite);
+
+        if (std::fwrite(outputBytes.get(), static_cast<size_t>(frameBytes), static_cast<size_t>(numToWrite), output) != static_cast<size_t>(numToWrite))
+            return juce::Result::fail("Write error on the output stream");
+    }
+
+    if (std::fflush(output) != 0)
+        return juce::Result::fail("Write error on the output stream");
+
+    if (stats != nullptr)
+    {
+        stats->audioSeconds = static_cast<double>(framesRead) / sampleRate;
+        stats->renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    }
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "Compressor.h"
+#include "FileRenderer.h"
+#include "PcmConversion.h"
+#include "RenderPreset.h"
+#include <cstdio>
+
+//==============================================================================
+// Filters raw interleaved PCM from one stream to another, for use inside
+// ffmpeg or sox pipelines:
+//
+//     ffmpeg -i in.mkv -f s24le -ac 2 -ar 48000 - |
+//         SondyCompRender --stream --preset p.json --rate 48000 --channels 2 --pcm s24 |
+//         ffmpeg -f s24le -ac 2 -ar 48000 -i - out.flac
+//
+// Chunks of a fixed number of frames are read, converted straight into the
+// planar float buffer the compressor processes, and converted back as they
+// are written, so memory is constant however long the stream runs. Output is
+// latency-compensated like FileRenderer's, and as long as the input.
+class StreamRenderer
+{
+public:
+    static constexpr int chunkSize = 4096; // frames
+
+    StreamRenderer(const RenderPreset& preset, PcmConversion::Format format, double sampleRate, int numChannels);
+
+    // Runs until input ends, then flushes and returns. Stats cover the frames
+    // read and the time from the first read to the last write
+    juce::Result run(std::FILE* input, std::FILE* output, FileRenderer::Stats* stats = nullptr);
+
+private:
+    const RenderPreset& preset;
+    const PcmConversion::Format format;
+    const double sampleRate;
+    const int numChannels;
+    const int frameBytes;
+
+    Compressor<float> compressor;
+    juce::AudioBuffer<float> buffer;
+    juce::HeapBlock<uint8_t> inputBytes, outputBytes;
+
+    JUCE_DECLARE_NON_COPYABLE(StreamRenderer)
+};
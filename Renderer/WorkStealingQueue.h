@@ -0,0 +1,74 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//==============================================================================
+// Job indices spread over one deque per worker. A worker takes jobs from the
+// front of its own deque; once that is empty it steals from the back of the
+// others, so a few long files dealt to one worker don't leave the rest idle
+// at the end of a batch.
+//
+// Jobs are whole files, so one short lock per deque operation is far below
+// anything measurable next to the render itself.
+class WorkStealingQueue
+{
+public:
+    explicit WorkStealingQueue(int numWorkers)
+    {
+        for (int worker = 0; worker < numWorkers; ++worker)
+            deques.push_back(std::make_unique<Deque>());
+    }
+
+    int getNumWorkers() const { return static_cast<int>(deques.size()); }
+
+    void push(int worker, int job)
+    {
+        auto& deque = *deques[static_cast<size_t>(worker)];
+        const std::lock_guard<std::mutex> lock(deque.mutex);
+        deque.jobs.push_back(job);
+    }
+
+    // The next job for worker, its own or stolen; -1 once every deque is empty.
+    // Nothing is pushed while a batch runs, so -1 means the batch is done
+    int pop(int worker)
+    {
+        {
+            auto& own = *deques[static_cast<size_t>(worker)];
+            const std::lock_guard<std::mutex> lock(own.mutex);
+            if (! own.jobs.empty())
+            {
+                const int job = own.jobs.front();
+                own.jobs.pop_front();
+                return job;
+            }
+        }
+
+        // Victims in turn, starting after this worker so thieves spread out
+        const int numWorkers = getNumWorkers();
+        for (int offset = 1; offset < numWorkers; ++offset)
+        {
+            auto& victim = *deques[static_cast<size_t>((worker + offset) % numWorkers)];
+            const std::lock_guard<std::mutex> lock(victim.mutex);
+            if (! victim.jobs.empty())
+            {
+                const int job = victim.jobs.back();
+                victim.jobs.pop_back();
+                return job;
+            }
+        }
+
+        return -1;
+    }
+
+private:
+    struct Deque
+    {
+        std::mutex mutex;
+        std::deque<int> jobs;
+    };
+
+    std::vector<std::unique_ptr<Deque>> deques;
+};
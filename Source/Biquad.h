@@ -0,0 +1,91 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+
+//==============================================================================
+// Second-order filter sections shared by the key filter and the crossovers.
+//
+// Coefficients are designed in double (RBJ cookbook) and stored at the
+// precision of the samples they filter, so they can be recomputed on the audio
+// thread without allocating. The state type is a template parameter so the
+// same section runs on a scalar or on a juce::dsp::SIMDRegister holding
+// several channels at once.
+template <typename CoefficientType>
+struct BiquadCoefficients
+{
+    CoefficientType b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+
+    // Q = 1/sqrt(2): Butterworth sections, and the allpass that a
+    // Linkwitz-Riley 4th-order low/high pair sums to
+    static constexpr double butterworthQ = 0.70710678118654752;
+
+    static BiquadCoefficients makeLowPass(double sampleRate, double frequency, double q = butterworthQ)
+    {
+        const auto d = Design(sampleRate, frequency, q);
+        return d.normalise((1.0 - d.cosOmega) / 2.0, 1.0 - d.cosOmega, (1.0 - d.cosOmega) / 2.0);
+    }
+
+    static BiquadCoefficients makeHighPass(double sampleRate, double frequency, double q = butterworthQ)
+    {
+        const auto d = Design(sampleRate, frequency, q);
+        return d.normalise((1.0 + d.cosOmega) / 2.0, -(1.0 + d.cosOmega), (1.0 + d.cosOmega) / 2.0);
+    }
+
+    static BiquadCoefficients makeAllPass(double sampleRate, double frequency, double q = butterworthQ)
+    {
+        const auto d = Design(sampleRate, frequency, q);
+        return d.normalise(1.0 - d.alpha, -2.0 * d.cosOmega, 1.0 + d.alpha);
+    }
+
+private:
+    struct Design
+    {
+        Design(double sampleRate, double frequency, double q)
+        {
+            const auto omega = juce::MathConstants<double>::twoPi
+                             * juce::jlimit(1.0, sampleRate * 0.49, frequency) / sampleRate;
+            cosOmega = std::cos(omega);
+            alpha = std::sin(omega) / (2.0 * q);
+        }
+
+        BiquadCoefficients normalise(double b0, double b1, double b2) const
+        {
+            const auto a0 = 1.0 + alpha;
+
+            BiquadCoefficients c;
+            c.b0 = static_cast<CoefficientType>(b0 / a0);
+            c.b1 = static_cast<CoefficientType>(b1 / a0);
+            c.b2 = static_cast<CoefficientType>(b2 / a0);
+            c.a1 = static_cast<CoefficientType>(-2.0 * cosOmega / a0);
+            c.a2 = static_cast<CoefficientType>((1.0 - alpha) / a0);
+            return c;
+        }
+
+        double cosOmega = 1.0;
+        double alpha = 0.0;
+    };
+};
+
+// Transposed direct form II state for one section. The coefficients may be
+// scalars shared by every lane, or registers with one section per lane
+template <typename Type>
+struct BiquadState
+{
+    Type s1 {}, s2 {};
+
+    template <typename Coefficients>
+    Type processSample(const Coefficients& c, Type x)
+    {
+        const Type y = x * c.b0 + s1;
+        s1 = x * c.b1 - y * c.a1 + s2;
+        s2 = x * c.b2 - y * c.a2;
+        return y;
+    }
+
+    void reset()
+    {
+        s1 = Type {};
+        s2 = Type {};
+    }
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+// Multichannel integer delay that works a block at a time, for the lookahead
+// audio path. Each block is written into a ring buffer and the delayed block
+// is read back with at most two contiguous copies per channel.
+template <typename SampleType>
+class BlockDelayLine
+{
+public:
+    // Allocate for delays up to maxDelaySamples and blocks up to maxBlockSize
+    void prepare(int numChannels, int maxDelaySamples, int maxBlockSize)
+    {
+        maxDelay = juce::jmax(0, maxDelaySamples);
+        ringSize = maxDelay + juce::jmax(1, maxBlockSize);
+        ring.setSize(juce::jmax(1, numChannels), ringSize);
+        delaySamples = juce::jmin(delaySamples, maxDelay);
+        reset();
+    }
+
+    void reset()
+    {
+        ring.clear();
+        writePosition = 0;
+    }
+
+    void setDelay(int newDelaySamples) { delaySamples = juce::jlimit(0, maxDelay, newDelaySamples); }
+    int getDelay() const { return delaySamples; }
+
+    // Delay every channel of the block in place
+    void process(const juce::dsp::AudioBlock<SampleType>& block)
+    {
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        const auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), ring.getNumChannels());
+        jassert(numSamples + maxDelay <= ringSize);
+
+        if (delaySamples == 0)
+            return;
+
+        const int readPosition = (writePosition - delaySamples + ringSize) % ringSize;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = block.getChannelPointer(static_cast<size_t>(channel));
+            auto* ringData = ring.getWritePointer(channel);
+
+            copyIntoRing(ringData, writePosition, data, numSamples);
+            copyFromRing(data, ringData, readPosition, numSamples);
+        }
+
+        writePosition = (writePosition + numSamples) % ringSize;
+    }
+
+private:
+    void copyIntoRing(SampleType* ringData, int position, const SampleType* source, int numSamples) const
+    {
+        const int firstPart = juce::jmin(numSamples, ringSize - position);
+        juce::FloatVectorOperations::copy(ringData + position, source, firstPart);
+        juce::FloatVectorOperations::copy(ringData, source + firstPart, numSamples - firstPart);
+    }
+
+    void copyFromRing(SampleType* dest, const SampleType* ringData, int position, int numSamples) const
+    {
+        const int firstPart = juce::jmin(numSamples, ringSize - position);
+        juce::FloatVectorOperations::copy(dest, ringData + position, firstPart);
+        juce::FloatVectorOperations::copy(dest + firstPart, ringData, numSamples - firstPart);
+    }
+
+    juce::AudioBuffer<SampleType> ring;
+    int ringSize = 1;
+    int maxDelay = 0;
+    int delaySamples = 0;
+    int writePosition = 0;
+};
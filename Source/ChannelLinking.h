@@ -0,0 +1,109 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+//==============================================================================
+// Builds channel-link groups for a bus layout: channels in the same group share
+// one detector and gain (see Compressor::setLinkGroups).
+namespace ChannelLinking
+{
+    enum class Mode
+    {
+        linked,          // every channel shares one gain
+        lfeIndependent,  // LFE channels on their own, everything else linked
+        byPosition,      // fronts, surrounds, heights and LFE as separate groups
+        unlinked         // every channel on its own
+    };
+
+    inline constexpr int numModes = 4;
+
+    inline bool isLfe(juce::AudioChannelSet::ChannelType type)
+    {
+        return type == juce::AudioChannelSet::LFE || type == juce::AudioChannelSet::LFE2;
+    }
+
+    inline bool isFront(juce::AudioChannelSet::ChannelType type)
+    {
+        using Set = juce::AudioChannelSet;
+        return type == Set::left || type == Set::right || type == Set::centre
+            || type == Set::leftCentre || type == Set::rightCentre
+            || type == Set::wideLeft || type == Set::wideRight;
+    }
+
+    inline bool isHeight(juce::AudioChannelSet::ChannelType type)
+    {
+        using Set = juce::AudioChannelSet;
+        return type == Set::topMiddle
+            || type == Set::topFrontLeft || type == Set::topFrontCentre || type == Set::topFrontRight
+            || type == Set::topRearLeft || type == Set::topRearCentre || type == Set::topRearRight
+            || type == Set::topSideLeft || type == Set::topSideRight;
+    }
+
+    // One group index per channel of the layout, counting from 0. Ambisonic
+    // components always stay linked: different gains per component would
+    // distort the sound field
+    inline std::vector<int> makeGroups(const juce::AudioChannelSet& layout, Mode mode)
+    {
+        const int numChannels = layout.size();
+        std::vector<int> groupOfChannel(static_cast<size_t>(numChannels), 0);
+
+        if (mode == Mode::linked || layout.getAmbisonicOrder() >= 0)
+            return groupOfChannel;
+
+        if (mode == Mode::unlinked)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                groupOfChannel[static_cast<size_t>(channel)] = channel;
+
+            return groupOfChannel;
+        }
+
+        // Category of each channel, numbered in order of first appearance
+        enum { front, surround, height, lfe, numCategories };
+        int categoryGroup[numCategories] = { -1, -1, -1, -1 };
+        int numGroups = 0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto type = layout.getTypeOfChannel(channel);
+
+            int category = front;
+            if (isLfe(type))
+                category = lfe;
+            else if (mode == Mode::byPosition)
+                category = isFront(type) ? front : (isHeight(type) ? height : surround);
+
+            if (categoryGroup[category] < 0)
+                categoryGroup[category] = numGroups++;
+
+            groupOfChannel[static_cast<size_t>(channel)] = categoryGroup[category];
+        }
+
+        return groupOfChannel;
+    }
+
+    // The main bus channel each channel of a sidechain layout stands for, by
+    // channel type, or -1 where the main bus has no such channel (see
+    // Compressor::setKeyChannelMap). A mono sidechain on a stereo bus, or a
+    // stereo one on the surrounds of a 5.1 bus, maps to no channel, and the
+    // groups it doesn't reach are keyed by the whole sidechain
+    inline std::vector<int> makeKeyChannelMap(const juce::AudioChannelSet& keyLayout, const juce::AudioChannelSet& mainLayout)
+    {
+        const int numKeyChannels = keyLayout.size();
+        std::vector<int> audioChannelOfKeyChannel(static_cast<size_t>(numKeyChannels), -1);
+
+        // Discrete channels have no position to match, so they go by index
+        const bool matchByIndex = keyLayout == mainLayout || keyLayout.isDiscreteLayout() || mainLayout.isDiscreteLayout();
+
+        for (int channel = 0; channel < numKeyChannels; ++channel)
+        {
+            if (matchByIndex)
+                audioChannelOfKeyChannel[static_cast<size_t>(channel)] = channel < mainLayout.size() ? channel : -1;
+            else
+                audioChannelOfKeyChannel[static_cast<size_t>(channel)] = mainLayout.getChannelIndexForType(keyLayout.getTypeOfChannel(channel));
+        }
+
+        return audioChannelOfKeyChannel;
+    }
+}
@@ -1,20 +1,114 @@
 #include "Compressor.h"
+#include "DecibelMath.h"
 #include <cmath>
 
-Compressor::Compressor()
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#elif JUCE_USE_ARM_NEON && JUCE_64BIT
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    // The detector runs in float at every sample type: |source| lands in a float buffer
+    void absToFloat(float* dest, const float* source, int numSamples)
+    {
+        juce::FloatVectorOperations::abs(dest, source, numSamples);
+    }
+    
+    // FloatVectorOperations has no mixed-precision kernels, and the plain loop
+    // only vectorizes at -O3, so the double versions convert four samples at a time
+    void absToFloat(float* dest, const double* source, int numSamples)
+    {
+        int i = 0;
+        
+       #if JUCE_USE_SSE_INTRINSICS
+        const auto signBit = _mm_set1_pd(-0.0);
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto low = _mm_cvtpd_ps(_mm_andnot_pd(signBit, _mm_loadu_pd(source + i)));
+            const auto high = _mm_cvtpd_ps(_mm_andnot_pd(signBit, _mm_loadu_pd(source + i + 2)));
+            _mm_storeu_ps(dest + i, _mm_movelh_ps(low, high));
+        }
+       #elif JUCE_USE_ARM_NEON && JUCE_64BIT
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto low = vcvt_f32_f64(vabsq_f64(vld1q_f64(source + i)));
+            vst1q_f32(dest + i, vcvt_high_f32_f64(low, vabsq_f64(vld1q_f64(source + i + 2))));
+        }
+       #endif
+        
+        for (; i < numSamples; ++i)
+            dest[i] = static_cast<float>(std::abs(source[i]));
+    }
+    
+    // dest[i] *= gain[i], with the gain coming from the float gain computer
+    void multiplyByGain(float* dest, const float* gain, int numSamples)
+    {
+        juce::FloatVectorOperations::multiply(dest, gain, numSamples);
+    }
+    
+    void multiplyByGain(double* dest, const float* gain, int numSamples)
+    {
+        int i = 0;
+        
+       #if JUCE_USE_SSE_INTRINSICS
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto gains = _mm_loadu_ps(gain + i);
+            _mm_storeu_pd(dest + i, _mm_mul_pd(_mm_loadu_pd(dest + i), _mm_cvtps_pd(gains)));
+            _mm_storeu_pd(dest + i + 2, _mm_mul_pd(_mm_loadu_pd(dest + i + 2), _mm_cvtps_pd(_mm_movehl_ps(gains, gains))));
+        }
+       #elif JUCE_USE_ARM_NEON && JUCE_64BIT
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto gains = vld1q_f32(gain + i);
+            vst1q_f64(dest + i, vmulq_f64(vld1q_f64(dest + i), vcvt_f64_f32(vget_low_f32(gains))));
+            vst1q_f64(dest + i + 2, vmulq_f64(vld1q_f64(dest + i + 2), vcvt_high_f64_f32(gains)));
+        }
+       #endif
+        
+        for (; i < numSamples; ++i)
+            dest[i] *= static_cast<double>(gain[i]);
+    }
+    
+    // x^exponent by squaring, for the steps of one control interval
+    float power(float x, int exponent)
+    {
+        float result = 1.0f;
+        for (; exponent > 0; exponent >>= 1, x *= x)
+            if ((exponent & 1) != 0)
+                result *= x;
+        
+        return result;
+    }
+}
+
+template <typename SampleType>
+Compressor<SampleType>::Compressor()
 {
     // Initialize attack wavetable with a linear ramp (0 to 1)
+    EnvelopeCurve::Points attackWavetable;
     for (int i = 0; i < attackWavetable.size(); ++i)
     {
         attackWavetable[i] = static_cast<float>(i) / (attackWavetable.size() - 1);
     }
+    EnvelopeCurve attackCurve;
+    attackCurve.setPoints(attackWavetable, wavetableResolution);
+    attackWavetables.reset(attackCurve);
     
     // Initialize release wavetable with an exponential decay (1 to 0)
+    EnvelopeCurve::Points releaseWavetable;
     for (int i = 0; i < releaseWavetable.size(); ++i)
     {
         float t = static_cast<float>(i) / (releaseWavetable.size() - 1);
         releaseWavetable[i] = 1.0f - t;
     }
+    EnvelopeCurve releaseCurve;
+    releaseCurve.setPoints(releaseWavetable, wavetableResolution);
+    releaseWavetables.reset(releaseCurve);
+    
+    updatePhaseIncrements();
     
     // Initialize gain reduction history
     for (auto& value : gainReductionHistory)
@@ -23,227 +117,950 @@ Compressor::Compressor()
     }
 }
 
-void Compressor::prepare(double newSampleRate, int samplesPerBlock)
+template <typename SampleType>
+void Compressor<SampleType>::prepare(double newSampleRate, int samplesPerBlock, int numChannels, int numKeyChannels)
 {
     sampleRate = newSampleRate;
-    // Reset envelope state
-    currentEnvelope = 0.0f;
-    currentGainReduction = 0.0f;
-    attackPhase = 0.0f;
-    releasePhase = 0.0f;
-    inAttack = false;
-    inRelease = false;
+    
+    // Preallocate the pipeline buffers for the largest block the host will send,
+    // at the highest oversampling factor
+    maxBlockSize = juce::jmax(1, samplesPerBlock);
+    const int maxProcessingBlockSize = maxBlockSize << maxOversamplingLog2;
+    
+    inputGainRamp.prepare(sampleRate, maxProcessingBlockSize, parameterRampSeconds);
+    outputGainRamp.prepare(sampleRate, maxProcessingBlockSize, parameterRampSeconds);
+    thresholdRamp.prepare(sampleRate, maxProcessingBlockSize, parameterRampSeconds);
+    
+    // One oversampler per factor, so switching factors never allocates
+    for (int factorLog2 = 1; factorLog2 <= maxOversamplingLog2; ++factorLog2)
+    {
+        auto& oversampler = oversamplers[static_cast<size_t>(factorLog2)];
+        oversampler = std::make_unique<juce::dsp::Oversampling<SampleType>>(
+            static_cast<size_t>(juce::jmax(1, numChannels)),
+            static_cast<size_t>(factorLog2),
+            juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple,
+            true,   // maximum quality
+            true);  // integer latency, so it can be reported to the host exactly
+        oversampler->initProcessing(static_cast<size_t>(maxBlockSize));
+        
+        // Upsampling only, for a filtered or external key
+        auto& keyOversampler = keyOversamplers[static_cast<size_t>(factorLog2)];
+        keyOversampler = std::make_unique<juce::dsp::Oversampling<SampleType>>(
+            static_cast<size_t>(juce::jmax(1, numKeyChannels)),
+            static_cast<size_t>(factorLog2),
+            juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple,
+            true,
+            true);
+        keyOversampler->initProcessing(static_cast<size_t>(maxBlockSize));
+    }
+    
+    // Key scratch and filter run at the host rate, before oversampling
+    keyBuffer.setSize(juce::jmax(1, numKeyChannels), maxBlockSize);
+    keyFilter.prepare(sampleRate, juce::jmax(1, numKeyChannels));
+    
+    // Lookahead sized for the longest delay at the highest processing rate
+    const int maxLookaheadSamples = (juce::roundToInt(maxLookaheadMs * 0.001 * sampleRate) + 1) << maxOversamplingLog2;
+    lookaheadDelay.prepare(numChannels, maxLookaheadSamples, maxProcessingBlockSize);
+    
+    // Enough link groups for every channel to run unlinked; existing
+    // assignments are kept for the channels that remain
+    const int maxRmsWindowSamples = juce::roundToInt(rmsWindowSeconds * sampleRate) << maxOversamplingLog2;
+    linkGroups.resize(static_cast<size_t>(juce::jmax(1, numChannels)));
+    for (auto& group : linkGroups)
+    {
+        group = LinkGroup {};
+        group.rmsDetector.prepare(maxRmsWindowSamples, maxProcessingBlockSize);
+        group.lookaheadPeak.prepare(maxLookaheadSamples + 1);
+        group.detectorBuffer.assign(static_cast<size_t>(maxProcessingBlockSize), 0.0f);
+        group.gainBuffer.assign(static_cast<size_t>(maxProcessingBlockSize), 0.0f);
+    }
+    
+    channelLinkGroup.resize(linkGroups.size(), 0);
+    numLinkGroups = 1;
+    for (auto& groupIndex : channelLinkGroup)
+    {
+        groupIndex = juce::jlimit(0, static_cast<int>(linkGroups.size()) - 1, groupIndex);
+        numLinkGroups = juce::jmax(numLinkGroups, groupIndex + 1);
+    }
+    
+    keyChannelMap.resize(static_cast<size_t>(keyBuffer.getNumChannels()));
+    for (size_t channel = 0; channel < keyChannelMap.size(); ++channel)
+        keyChannelMap[channel] = static_cast<int>(channel);
+    
+    activeOversamplingLog2 = -1;
+    updateOversampling();
+    updateLookahead();
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::reset()
+{
+    for (auto& group : linkGroups)
+    {
+        group.currentGainReduction = 0.0f;
+        group.currentInputLevel = -100.0f;
+        group.attackPhase = 0.0f;
+        group.releasePhase = 0.0f;
+        group.inAttack = false;
+        group.inRelease = false;
+        group.atRest = false;
+        group.rmsDetector.reset();
+        group.lookaheadPeak.reset();
+    }
+    
+    lookaheadDelay.reset();
+    keyFilter.reset();
+    
+    for (auto& oversampler : oversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+    
+    for (auto& keyOversampler : keyOversamplers)
+        if (keyOversampler != nullptr)
+            keyOversampler->reset();
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::process(juce::AudioBuffer<SampleType>& buffer)
+{
+    processBlock(juce::dsp::AudioBlock<SampleType>(buffer), nullptr);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::process(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    processBlock(block, nullptr);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::process(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>& detectorInput)
+{
+    process(juce::dsp::AudioBlock<SampleType>(buffer), juce::dsp::AudioBlock<const SampleType>(detectorInput));
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::process(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<const SampleType>& detectorInput)
+{
+    processBlock(block, &detectorInput);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::processBlock(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<const SampleType>* detectorInput)
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    
+    jassert(maxBlockSize > 0); // prepare() must be called before process()
+    jassert(detectorInput == nullptr || static_cast<int>(detectorInput->getNumSamples()) >= numSamples);
+    
+    // The oversamplers, delay line and link groups only have the channels
+    // allocated in prepare(); any beyond them pass through untouched
+    jassert(block.getNumChannels() <= channelLinkGroup.size());
+    const auto numChannels = juce::jmin(block.getNumChannels(), channelLinkGroup.size());
+    const auto audio = block.getSubsetChannelBlock(0, numChannels);
+    
+    if (numChannels == 0 || numSamples == 0 || maxBlockSize == 0
+        || (detectorInput != nullptr && detectorInput->getNumChannels() == 0))
+        return;
+    
+    // Pick up wavetables published since the last block
+    attackWavetables.acquireLatest();
+    releaseWavetables.acquireLatest();
+    
+    // Apply a changed oversampling factor or lookahead at the block boundary
+    updateOversampling();
+    updateLookahead();
+    auto* oversampler = oversamplers[static_cast<size_t>(activeOversamplingLog2)].get();
+    auto* keyOversampler = keyOversamplers[static_cast<size_t>(activeOversamplingLog2)].get();
+    
+    // The key is the audio itself unless it has to be filtered or comes from elsewhere
+    const bool keyIsAudio = detectorInput == nullptr && ! keyFilter.isActive();
+    const juce::dsp::AudioBlock<const SampleType> detectorBlock = detectorInput != nullptr ? *detectorInput : juce::dsp::AudioBlock<const SampleType>(audio);
+    const auto numKeyChannels = juce::jmin(detectorBlock.getNumChannels(), static_cast<size_t>(keyBuffer.getNumChannels()));
+    
+    // Hosts may exceed the prepared block size, so larger buffers are
+    // processed in chunks that fit the scratch buffers
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+    {
+        const auto chunkStart = static_cast<size_t>(start);
+        const auto chunkSize = static_cast<size_t>(juce::jmin(maxBlockSize, numSamples - start));
+        auto chunk = audio.getSubBlock(chunkStart, chunkSize);
+        
+        if (keyIsAudio)
+        {
+            if (oversampler == nullptr)
+            {
+                processChunk(chunk, chunk, false);
+            }
+            else
+            {
+                // The oversampler returns every channel it was prepared for, so
+                // the block keeps the channel count it has without oversampling
+                auto oversampled = oversampler->processSamplesUp(chunk).getSubsetChannelBlock(0, chunk.getNumChannels());
+                processChunk(oversampled, oversampled, false);
+                oversampler->processSamplesDown(chunk);
+            }
+            continue;
+        }
+        
+        // Copy the key into scratch and run it through the key filter
+        auto key = juce::dsp::AudioBlock<SampleType>(keyBuffer).getSubsetChannelBlock(0, numKeyChannels).getSubBlock(0, chunkSize);
+        key.copyFrom(detectorBlock.getSubsetChannelBlock(0, numKeyChannels).getSubBlock(chunkStart, chunkSize));
+        keyFilter.process(key);
+        
+        if (oversampler == nullptr)
+        {
+            processChunk(chunk, key, detectorInput != nullptr);
+        }
+        else
+        {
+            // The key goes through an identical upsampler so it stays aligned with
+            // the audio, and keeps its channel count so it links the same way
+            auto oversampledKey = keyOversampler->processSamplesUp(key).getSubsetChannelBlock(0, numKeyChannels);
+            processChunk(oversampler->processSamplesUp(chunk).getSubsetChannelBlock(0, chunk.getNumChannels()), oversampledKey, detectorInput != nullptr);
+            oversampler->processSamplesDown(chunk);
+        }
+    }
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setOversamplingFactor(int factorLog2)
+{
+    requestedOversamplingLog2 = juce::jlimit(0, maxOversamplingLog2, factorLog2);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setLookahead(float newLookaheadMs)
+{
+    requestedLookaheadMs = juce::jlimit(0.0f, maxLookaheadMs, newLookaheadMs);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setLinkGroups(const int* groupOfChannel, int numChannels)
+{
+    const int numGroupsAvailable = static_cast<int>(linkGroups.size());
+    const int channelsToSet = juce::jmin(numChannels, static_cast<int>(channelLinkGroup.size()));
+    
+    int newNumLinkGroups = 1;
+    for (int channel = 0; channel < channelsToSet; ++channel)
+    {
+        const int groupIndex = juce::jlimit(0, numGroupsAvailable - 1, groupOfChannel[channel]);
+        channelLinkGroup[static_cast<size_t>(channel)] = groupIndex;
+        newNumLinkGroups = juce::jmax(newNumLinkGroups, groupIndex + 1);
+    }
+    
+    numLinkGroups = newNumLinkGroups;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setKeyChannelMap(const int* audioChannelOfKeyChannel, int numKeyChannels)
+{
+    const int numChannels = static_cast<int>(channelLinkGroup.size());
+    for (size_t channel = 0; channel < keyChannelMap.size(); ++channel)
+    {
+        const int audioChannel = static_cast<int>(channel) < numKeyChannels ? audioChannelOfKeyChannel[channel] : -1;
+        keyChannelMap[channel] = juce::isPositiveAndBelow(audioChannel, numChannels) ? audioChannel : -1;
+    }
+}
+
+template <typename SampleType>
+int Compressor<SampleType>::getLatencySamples() const
+{
+    return oversamplingLatency + lookaheadLatency;
 }
 
-void Compressor::process(juce::AudioBuffer<float>& buffer)
+template <typename SampleType>
+void Compressor<SampleType>::updateOversampling()
 {
-    const auto numChannels = buffer.getNumChannels();
-    const auto numSamples = buffer.getNumSamples();
+    if (requestedOversamplingLog2 == activeOversamplingLog2)
+        return;
     
-    // Apply input gain
-    buffer.applyGain(juce::Decibels::decibelsToGain(inputGain));
+    activeOversamplingLog2 = requestedOversamplingLog2;
+    processingRate = sampleRate * static_cast<double>(1 << activeOversamplingLog2);
     
-    // Process each sample
-    for (int sample = 0; sample < numSamples; ++sample)
+    // Ramps and envelope steps run at the oversampled rate
+    inputGainRamp.setSampleRate(processingRate, parameterRampSeconds);
+    outputGainRamp.setSampleRate(processingRate, parameterRampSeconds);
+    thresholdRamp.setSampleRate(processingRate, parameterRampSeconds);
+    
+    oversamplingLatency = 0;
+    if (auto* keyOversampler = keyOversamplers[static_cast<size_t>(activeOversamplingLog2)].get())
+        keyOversampler->reset();
+    
+    if (auto* oversampler = oversamplers[static_cast<size_t>(activeOversamplingLog2)].get())
     {
-        // Find the maximum absolute sample value across all channels
-        float maxLevel = 0.0f;
-        for (int channel = 0; channel < numChannels; ++channel)
+        oversampler->reset();
+        oversamplingLatency = juce::roundToInt(oversampler->getLatencyInSamples());
+    }
+    
+    for (auto& group : linkGroups)
+        group.rmsDetector.setWindowLength(juce::roundToInt(rmsWindowSeconds * processingRate));
+    
+    ecoInterval = processingRate <= 50000.0 ? 4 : (processingRate <= 100000.0 ? 8 : 16);
+    updatePhaseIncrements();
+    
+    // The lookahead length is counted in processing-rate samples
+    activeLookaheadMs = -1.0f;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::updateLookahead()
+{
+    if (requestedLookaheadMs == activeLookaheadMs)
+        return;
+    
+    activeLookaheadMs = requestedLookaheadMs;
+    
+    // A whole number of host samples, so the reported latency is exact
+    lookaheadLatency = juce::roundToInt(activeLookaheadMs * 0.001 * sampleRate);
+    const int lookaheadSamples = lookaheadLatency << activeOversamplingLog2;
+    
+    // Both skip their state while lookahead is off, and a new delay would jump
+    // the read position, so they start over from silence
+    lookaheadDelay.setDelay(lookaheadSamples);
+    lookaheadDelay.reset();
+    
+    for (auto& group : linkGroups)
+    {
+        group.lookaheadPeak.setWindowLength(lookaheadSamples + 1);
+        group.lookaheadPeak.reset();
+    }
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::processChunk(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& key, bool externalKey)
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    
+    // Render parameter ramps; settled parameters write nothing
+    inputGainRamp.advance(numSamples);
+    outputGainRamp.advance(numSamples);
+    thresholdRamp.advance(numSamples);
+    
+    // Below the knee start the static curve gives exactly no reduction. With
+    // the envelope settled at zero it then stays there, so a group whose whole
+    // chunk is below that level can skip the log/exp math and the envelope
+    const bool canRest = ! thresholdRamp.isRamping();
+    const float restLevel = DecibelMath::decibelsToGain(thresholdRamp.getConstant() - knee / 2.0f - restMarginDb);
+    bool allAtRest = true;
+    
+    for (int groupIndex = 0; groupIndex < numLinkGroups; ++groupIndex)
+    {
+        auto& group = linkGroups[static_cast<size_t>(groupIndex)];
+        
+        // 1. Linked peak across the group's key channels (vectorized). Always
+        //    run, so the RMS window and lookahead state stay continuous
+        computeLinkedPeak(groupIndex, key, externalKey);
+        
+        const auto* peak = group.detectorBuffer.data();
+        group.atRest = canRest && group.currentGainReduction == 0.0f
+                    && juce::FloatVectorOperations::findMaximum(peak, numSamples) < restLevel;
+        
+        if (group.atRest)
         {
-            auto* channelData = buffer.getReadPointer(channel);
-            maxLevel = std::max(maxLevel, std::abs(channelData[sample]));
+            // Exactly what the envelope would have left behind
+            group.currentInputLevel = DecibelMath::gainToDecibels(peak[numSamples - 1]);
+            group.inAttack = false;
+            group.inRelease = false;
+            juce::FloatVectorOperations::clear(group.gainBuffer.data(), numSamples);
+            continue;
         }
         
-        // Convert to dB
-        float inputLevelDB = maxLevel > 0.0f ? juce::Decibels::gainToDecibels(maxLevel) : -100.0f;
+        allAtRest = false;
         
-        // Store the current input level for visualization
-        currentInputLevel = inputLevelDB;
+        // 2. Static curve: peak level -> target gain reduction in dB
+        computeTargetGainReduction(group, numSamples);
         
-        // Calculate gain reduction and update envelope
-        updateEnvelope(inputLevelDB);
+        // 3. Attack/release envelope (serial), or at control rate in eco mode.
+        //    Peak and hybrid targets follow the waveform, where eco cannot stay
+        //    close to the per-sample envelope, so only the RMS detector runs eco
+        if (envelopeMode == EnvelopeMode::eco && detectorMode == DetectorMode::rms)
+            runEnvelopeEco(group, numSamples);
+        else
+            runEnvelope(group, numSamples);
+    }
+    
+    if (allAtRest)
+    {
+        updateHistoryAtRest(numSamples);
+        applyRestingGain(block);
+        return;
+    }
+    
+    updateHistory(numSamples);
+    
+    // 4. Gain reduction -> linear gain, then multiply every channel by its
+    //    group's gain buffer (vectorized)
+    for (int groupIndex = 0; groupIndex < numLinkGroups; ++groupIndex)
+        gainReductionToGain(linkGroups[static_cast<size_t>(groupIndex)], numSamples);
+    
+    applyGainToChannels(block);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::computeLinkedPeak(int groupIndex, const juce::dsp::AudioBlock<SampleType>& key, bool externalKey)
+{
+    auto& group = linkGroups[static_cast<size_t>(groupIndex)];
+    const auto numSamples = static_cast<int>(key.getNumSamples());
+    const auto numKeyChannels = key.getNumChannels();
+    auto* peak = group.detectorBuffer.data();
+    
+    // The key channels standing for the group's audio channels; an external
+    // key with none of them (e.g. a stereo sidechain on the surrounds of a
+    // 5.1 bus) keys the group from all its channels
+    auto keysGroup = [&](size_t channel)
+    {
+        const int audioChannel = externalKey ? keyChannelMap[channel] : static_cast<int>(channel);
+        return audioChannel >= 0 && channelLinkGroup[static_cast<size_t>(audioChannel)] == groupIndex;
+    };
+    
+    bool wholeKey = externalKey;
+    for (size_t channel = 0; channel < numKeyChannels && wholeKey; ++channel)
+        wholeKey = ! keysGroup(channel);
+    
+    // Find the maximum absolute sample value across the group's channels, a
+    // whole channel block at a time. gainBuffer is free until the envelope
+    // pass, so it holds each channel's magnitude
+    auto* magnitude = group.gainBuffer.data();
+    bool hasChannel = false;
+    for (size_t channel = 0; channel < numKeyChannels; ++channel)
+    {
+        if (! wholeKey && ! keysGroup(channel))
+            continue;
         
-        // Apply gain reduction to all channels
-        float gainFactor = juce::Decibels::decibelsToGain(-currentGainReduction);
-        for (int channel = 0; channel < numChannels; ++channel)
+        if (! hasChannel)
         {
-            auto* channelData = buffer.getWritePointer(channel);
-            channelData[sample] *= gainFactor;
+            absToFloat(peak, key.getChannelPointer(channel), numSamples);
+            hasChannel = true;
+            continue;
         }
         
-        // Store gain reduction for visualization
-        gainReductionHistory[historyIndex] = currentGainReduction;
-        historyIndex = (historyIndex + 1) % gainReductionHistory.size();
+        absToFloat(magnitude, key.getChannelPointer(channel), numSamples);
+        juce::FloatVectorOperations::max(peak, peak, magnitude, numSamples);
     }
     
-    // Apply output gain
-    buffer.applyGain(juce::Decibels::decibelsToGain(outputGain));
+    if (! hasChannel)
+        juce::FloatVectorOperations::clear(peak, numSamples);
+    
+    // Peak, RMS or a blend of both
+    if (detectorMode == DetectorMode::rms)
+    {
+        group.rmsDetector.process(peak, peak, numSamples);
+    }
+    else if (detectorMode == DetectorMode::hybrid)
+    {
+        group.rmsDetector.process(peak, magnitude, numSamples);
+        juce::FloatVectorOperations::add(peak, magnitude, numSamples);
+        juce::FloatVectorOperations::multiply(peak, 0.5f, numSamples);
+    }
+    
+    // With lookahead, each sample sees the peak of the window the delayed audio
+    // is about to play through
+    group.lookaheadPeak.process(peak, peak, numSamples);
+    
+    // The input gain is folded into the detector and the final gain multiply
+    // instead of being applied to the audio in a separate pass
+    inputGainRamp.multiply(peak, numSamples);
 }
 
-float Compressor::calculateGainReduction(float inputLevelDB)
+template <typename SampleType>
+void Compressor<SampleType>::computeTargetGainReduction(LinkGroup& group, int numSamples)
 {
-    // Fixed ratio of 4:1
-    const float ratio = 4.0f;
+    auto* levels = group.detectorBuffer.data();
+    
+    // Convert to dB in place (vectorized)
+    DecibelMath::gainToDecibels(levels, levels, numSamples);
     
-    if (inputLevelDB <= threshold - knee / 2.0f)
+    // Store the last input level for visualization
+    group.currentInputLevel = levels[numSamples - 1];
+    
+    // Relative to the threshold, then through the static curve
+    // (branch-free, specialized once per block)
+    thresholdRamp.subtract(levels, numSamples);
+    transferCurve.evaluate(levels, levels, numSamples);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::runEnvelope(LinkGroup& group, int numSamples)
+{
+    const auto* targets = group.detectorBuffer.data();
+    auto* gains = group.gainBuffer.data();
+    
+    // The envelope is a recurrence, so this pass stays scalar
+    for (int i = 0; i < numSamples; ++i)
     {
-        // Below threshold - no gain reduction
-        return 0.0f;
+        updateEnvelope(group, targets[i]);
+        gains[i] = group.currentGainReduction;
     }
-    else if (inputLevelDB > threshold + knee / 2.0f)
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::runEnvelopeEco(LinkGroup& group, int numSamples)
+{
+    switch (ecoInterval)
     {
-        // Above threshold + knee - full compression with ratio
-        return (inputLevelDB - threshold) * (1.0f - 1.0f / ratio);
+        case 4:  runEnvelopeControlRate<4>(group, numSamples); break;
+        case 8:  runEnvelopeControlRate<8>(group, numSamples); break;
+        default: runEnvelopeControlRate<16>(group, numSamples); break;
     }
-    else
+}
+
+// One envelope update per interval, towards the target at its end, and a
+// linear ramp up to it. The interval length is fixed, so the min/max scan and
+// the ramp unroll into a few vector operations; only the chunk's last,
+// shorter interval runs the generic loop
+template <typename SampleType>
+template <int interval>
+void Compressor<SampleType>::runEnvelopeControlRate(LinkGroup& group, int numSamples)
+{
+    const auto* targets = group.detectorBuffer.data();
+    auto* gains = group.gainBuffer.data();
+    
+    auto runInterval = [&](int start, int length)
+    {
+        float highest = targets[start], lowest = targets[start];
+        for (int i = 1; i < length; ++i)
+        {
+            highest = juce::jmax(highest, targets[start + i]);
+            lowest = juce::jmin(lowest, targets[start + i]);
+        }
+        const float target = targets[start + length - 1];
+        const float previous = group.currentGainReduction;
+        
+        // A step the other way restarts the phase, as it would per sample
+        if (target > previous && lowest < previous)
+            group.attackPhase = 0.0f;
+        else if (target < previous && highest > previous)
+            group.releasePhase = 0.0f;
+        
+        advanceEnvelope(group, target, length);
+        
+        const float step = (group.currentGainReduction - previous) / static_cast<float>(length);
+        for (int i = 0; i < length; ++i)
+            gains[start + i] = previous + step * static_cast<float>(i + 1);
+    };
+    
+    int start = 0;
+    for (; start + interval <= numSamples; start += interval)
+        runInterval(start, interval);
+    
+    if (start < numSamples)
+        runInterval(start, numSamples - start);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::updateHistory(int numSamples)
+{
+    // Only the most recent samples survive in the visualization history,
+    // which shows the deepest reduction across the link groups
+    const int historySize = static_cast<int>(gainReductionHistory.size());
+    for (int i = juce::jmax(0, numSamples - historySize); i < numSamples; ++i)
+    {
+        float deepest = linkGroups[0].gainBuffer[static_cast<size_t>(i)];
+        for (int groupIndex = 1; groupIndex < numLinkGroups; ++groupIndex)
+            deepest = juce::jmax(deepest, linkGroups[static_cast<size_t>(groupIndex)].gainBuffer[static_cast<size_t>(i)]);
+        
+        gainReductionHistory[historyIndex] = deepest;
+        historyIndex = (historyIndex + 1) % historySize;
+    }
+    
+    restingHistorySamples = 0;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::updateHistoryAtRest(int numSamples)
+{
+    // Once the whole history shows no reduction there is nothing left to write
+    const int historySize = static_cast<int>(gainReductionHistory.size());
+    const int samplesToWrite = juce::jmin(numSamples, historySize - restingHistorySamples);
+    
+    for (int i = 0; i < samplesToWrite; ++i)
     {
-        // In the knee region - soft knee compression
-        float kneeRatio = (inputLevelDB - (threshold - knee / 2.0f)) / knee;
-        float slope = 1.0f - 1.0f / ratio;
-        return kneeRatio * kneeRatio * (inputLevelDB - threshold) * slope;
+        gainReductionHistory[historyIndex] = 0.0f;
+        historyIndex = (historyIndex + 1) % historySize;
     }
+    
+    restingHistorySamples += juce::jmax(0, samplesToWrite);
 }
 
-void Compressor::updateEnvelope(float inputLevelDB)
+template <typename SampleType>
+void Compressor<SampleType>::applyRestingGain(const juce::dsp::AudioBlock<SampleType>& block)
 {
-    // Calculate target gain reduction based on the input level
-    float targetGainReduction = calculateGainReduction(inputLevelDB);
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    
+    // The delay line has to see every sample, resting or not
+    lookaheadDelay.process(block);
+    
+    const auto numChannels = block.getNumChannels();
+    jassert(numChannels <= channelLinkGroup.size());
     
+    // Settled input and output gain: one constant multiply, or none at unity
+    if (! inputGainRamp.isRamping() && ! outputGainRamp.isRamping())
+    {
+        const float gain = inputGainRamp.getConstant() * outputGainRamp.getConstant();
+        if (gain == 1.0f)
+            return;
+        
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::multiply(block.getChannelPointer(channel), static_cast<SampleType>(gain), numSamples);
+        
+        return;
+    }
+    
+    // Ramping: every group shares the same gain, so build it once
+    auto* gains = linkGroups[0].gainBuffer.data();
+    juce::FloatVectorOperations::fill(gains, 1.0f, numSamples);
+    inputGainRamp.multiply(gains, numSamples);
+    outputGainRamp.multiply(gains, numSamples);
+    
+    for (size_t channel = 0; channel < numChannels; ++channel)
+        multiplyByGain(block.getChannelPointer(channel), gains, numSamples);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::gainReductionToGain(LinkGroup& group, int numSamples)
+{
+    auto* gains = group.gainBuffer.data();
+    
+    // Gain reduction (dB) -> linear gain, with input and output gain folded in
+    juce::FloatVectorOperations::negate(gains, gains, numSamples);
+    DecibelMath::decibelsToGain(gains, gains, numSamples);
+    inputGainRamp.multiply(gains, numSamples);
+    outputGainRamp.multiply(gains, numSamples);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::applyGainToChannels(const juce::dsp::AudioBlock<SampleType>& block)
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    
+    // Delay the audio by the lookahead time so the gain lands ahead of transients
+    lookaheadDelay.process(block);
+    
+    const auto numChannels = block.getNumChannels();
+    jassert(numChannels <= channelLinkGroup.size());
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        const auto& group = linkGroups[static_cast<size_t>(channelLinkGroup[channel])];
+        multiplyByGain(block.getChannelPointer(channel), group.gainBuffer.data(), numSamples);
+    }
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::updateEnvelope(LinkGroup& group, float targetGainReduction)
+{
     // If target is greater than current (more reduction needed) -> attack phase
-    if (targetGainReduction > currentGainReduction)
+    if (targetGainReduction > group.currentGainReduction)
     {
         // Start attack phase
-        inAttack = true;
-        inRelease = false;
-        releasePhase = 0.0f;
-        
-        // Calculate steps per sample for attack
-        float samplesPerAttack = attackTime * sampleRate;
-        float attackStep = 1.0f / samplesPerAttack;
+        group.inAttack = true;
+        group.inRelease = false;
+        group.releasePhase = 0.0f;
         
         // Move along attack curve
-        attackPhase += attackStep;
-        if (attackPhase > 1.0f)
-            attackPhase = 1.0f;
+        group.attackPhase += attackPhaseIncrement;
+        if (group.attackPhase > 1.0f)
+            group.attackPhase = 1.0f;
         
         // Get attack curve value
-        int wavetableIndex = static_cast<int>(attackPhase * (attackWavetable.size() - 1));
-        wavetableIndex = juce::jlimit(0, static_cast<int>(attackWavetable.size()) - 1, wavetableIndex);
-        float attackCurveValue = attackWavetable[wavetableIndex];
+        float attackCurveValue = attackWavetables.getCurrent().lookUp(group.attackPhase, wavetableInterpolation);
         
         // Apply attack curve
-        currentGainReduction = currentGainReduction + attackCurveValue * (targetGainReduction - currentGainReduction);
+        group.currentGainReduction = group.currentGainReduction + attackCurveValue * (targetGainReduction - group.currentGainReduction);
         
         // Exit attack if we reached target
-        if (attackPhase >= 1.0f)
+        if (group.attackPhase >= 1.0f)
         {
-            currentGainReduction = targetGainReduction;
-            inAttack = false;
+            group.currentGainReduction = targetGainReduction;
+            group.inAttack = false;
         }
     }
     // If target is less than current (less reduction needed) -> release phase
-    else if (targetGainReduction < currentGainReduction)
+    else if (targetGainReduction < group.currentGainReduction)
     {
         // Start release phase
-        inRelease = true;
-        inAttack = false;
-        attackPhase = 0.0f;
-        
-        // Calculate steps per sample for release
-        float samplesPerRelease = releaseTime * sampleRate;
-        float releaseStep = 1.0f / samplesPerRelease;
+        group.inRelease = true;
+        group.inAttack = false;
+        group.attackPhase = 0.0f;
         
         // Move along release curve
-        releasePhase += releaseStep;
-        if (releasePhase > 1.0f)
-            releasePhase = 1.0f;
+        group.releasePhase += releasePhaseIncrement;
+        if (group.releasePhase > 1.0f)
+            group.releasePhase = 1.0f;
         
         // Get release curve value
-        int wavetableIndex = static_cast<int>(releasePhase * (releaseWavetable.size() - 1));
-        wavetableIndex = juce::jlimit(0, static_cast<int>(releaseWavetable.size()) - 1, wavetableIndex);
-        float releaseCurveValue = releaseWavetable[wavetableIndex];
+        float releaseCurveValue = releaseWavetables.getCurrent().lookUp(group.releasePhase, wavetableInterpolation);
         
         // Apply release curve
-        float reduction = currentGainReduction - targetGainReduction;
-        currentGainReduction = targetGainReduction + reduction * releaseCurveValue;
+        float reduction = group.currentGainReduction - targetGainReduction;
+        group.currentGainReduction = targetGainReduction + reduction * releaseCurveValue;
         
         // Exit release if we reached target
-        if (releasePhase >= 1.0f)
+        if (group.releasePhase >= 1.0f)
         {
-            currentGainReduction = targetGainReduction;
-            inRelease = false;
+            group.currentGainReduction = targetGainReduction;
+            group.inRelease = false;
         }
     }
     else
     {
         // No change needed - already at target gain reduction
-        currentGainReduction = targetGainReduction;
-        inAttack = false;
-        inRelease = false;
+        group.currentGainReduction = targetGainReduction;
+        group.inAttack = false;
+        group.inRelease = false;
     }
 }
 
-void Compressor::setThreshold(float newThreshold)
+// numSteps samples of updateEnvelope() against one target in a single update.
+// Every step moves the envelope by the curve value at its phase; the value at
+// the middle phase stands for all of them, so the remaining distance to the
+// target shrinks by that step's factor to the power numSteps. Where the phase
+// reaches the end of the curve, the envelope lands on the target.
+//
+// The benchmark's --check run renders eco against per-sample and fails above
+// GoldenRender::maxEcoErrorDb and maxEcoRmsErrorDb.
+template <typename SampleType>
+void Compressor<SampleType>::advanceEnvelope(LinkGroup& group, float targetGainReduction, int numSteps)
 {
+    const float steps = static_cast<float>(numSteps);
+    
+    if (targetGainReduction > group.currentGainReduction)
+    {
+        group.inAttack = true;
+        group.inRelease = false;
+        group.releasePhase = 0.0f;
+        
+        const float middlePhase = group.attackPhase + attackPhaseIncrement * 0.5f * (steps + 1.0f);
+        group.attackPhase = juce::jmin(1.0f, group.attackPhase + attackPhaseIncrement * steps);
+        
+        if (group.attackPhase >= 1.0f)
+        {
+            group.currentGainReduction = targetGainReduction;
+            group.inAttack = false;
+            return;
+        }
+        
+        const float curveValue = attackWavetables.getCurrent().lookUp(middlePhase, wavetableInterpolation);
+        group.currentGainReduction = targetGainReduction
+            - (targetGainReduction - group.currentGainReduction) * power(1.0f - curveValue, numSteps);
+    }
+    else if (targetGainReduction < group.currentGainReduction)
+    {
+        group.inRelease = true;
+        group.inAttack = false;
+        group.attackPhase = 0.0f;
+        
+        const float middlePhase = group.releasePhase + releasePhaseIncrement * 0.5f * (steps + 1.0f);
+        group.releasePhase = juce::jmin(1.0f, group.releasePhase + releasePhaseIncrement * steps);
+        
+        if (group.releasePhase >= 1.0f)
+        {
+            group.currentGainReduction = targetGainReduction;
+            group.inRelease = false;
+            return;
+        }
+        
+        const float curveValue = releaseWavetables.getCurrent().lookUp(middlePhase, wavetableInterpolation);
+        group.currentGainReduction = targetGainReduction
+            + (group.currentGainReduction - targetGainReduction) * power(curveValue, numSteps);
+    }
+    else
+    {
+        group.inAttack = false;
+        group.inRelease = false;
+    }
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setThreshold(float newThreshold)
+{
+    if (newThreshold == threshold)
+        return;
+    
     threshold = newThreshold;
+    thresholdRamp.setTargetValue(threshold);
 }
 
-void Compressor::setKnee(float newKnee)
+template <typename SampleType>
+void Compressor<SampleType>::setKnee(float newKnee)
 {
+    if (newKnee == knee)
+        return;
+    
     knee = newKnee;
+    transferCurve.compile(0.0f, knee, ratio);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setRatio(float newRatio)
+{
+    if (newRatio == ratio)
+        return;
+    
+    ratio = newRatio;
+    transferCurve.compile(0.0f, knee, ratio);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setDetectorMode(DetectorMode newMode)
+{
+    if (newMode == detectorMode)
+        return;
+    
+    // The RMS window only runs while it is in use, so start it from silence
+    if (detectorMode == DetectorMode::peak)
+        for (auto& group : linkGroups)
+            group.rmsDetector.reset();
+    
+    detectorMode = newMode;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setEnvelopeMode(EnvelopeMode newMode)
+{
+    envelopeMode = newMode;
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setKeyHighPass(float frequencyHz)
+{
+    keyFilter.setHighPassFrequency(frequencyHz);
+}
+
+template <typename SampleType>
+void Compressor<SampleType>::setKeyLowPass(float frequencyHz)
+{
+    keyFilter.setLowPassFrequency(frequencyHz);
 }
 
-void Compressor::setInputGain(float newInputGain)
+template <typename SampleType>
+void Compressor<SampleType>::setInputGain(float newInputGain)
 {
+    if (newInputGain == inputGain)
+        return;
+    
     inputGain = newInputGain;
+    inputGainRamp.setTargetValue(DecibelMath::decibelsToGain(inputGain));
 }
 
-void Compressor::setOutputGain(float newOutputGain)
+template <typename SampleType>
+void Compressor<SampleType>::setOutputGain(float newOutputGain)
 {
+    if (newOutputGain == outputGain)
+        return;
+    
     outputGain = newOutputGain;
+    outputGainRamp.setTargetValue(DecibelMath::decibelsToGain(outputGain));
 }
 
-void Compressor::setAttackTime(float newAttackTimeSeconds)
+template <typename SampleType>
+void Compressor<SampleType>::setAttackTime(float newAttackTimeSeconds)
 {
+    if (newAttackTimeSeconds == attackTime)
+        return;
+    
     attackTime = newAttackTimeSeconds;
+    updatePhaseIncrements();
 }
 
-void Compressor::setReleaseTime(float newReleaseTimeSeconds)
+template <typename SampleType>
+void Compressor<SampleType>::setReleaseTime(float newReleaseTimeSeconds)
 {
+    if (newReleaseTimeSeconds == releaseTime)
+        return;
+    
     releaseTime = newReleaseTimeSeconds;
+    updatePhaseIncrements();
 }
 
-void Compressor::setAttackWavetable(const std::array<float, 256>& wavetable)
+template <typename SampleType>
+void Compressor<SampleType>::updatePhaseIncrements()
 {
-    attackWavetable = wavetable;
+    attackPhaseIncrement = static_cast<float>(1.0 / (static_cast<double>(attackTime) * processingRate));
+    releasePhaseIncrement = static_cast<float>(1.0 / (static_cast<double>(releaseTime) * processingRate));
 }
 
-void Compressor::setReleaseWavetable(const std::array<float, 256>& wavetable)
+template <typename SampleType>
+void Compressor<SampleType>::setAttackWavetable(const std::array<float, 256>& wavetable)
 {
-    releaseWavetable = wavetable;
+    publishWavetable(attackWavetables, wavetable);
 }
 
-const std::array<float, 256>& Compressor::getAttackWavetable() const
+template <typename SampleType>
+void Compressor<SampleType>::setReleaseWavetable(const std::array<float, 256>& wavetable)
 {
-    return attackWavetable;
+    publishWavetable(releaseWavetables, wavetable);
 }
 
-const std::array<float, 256>& Compressor::getReleaseWavetable() const
+template <typename SampleType>
+void Compressor<SampleType>::publishWavetable(WavetableExchange<EnvelopeCurve>& wavetables, const EnvelopeCurve::Points& points)
 {
-    return releaseWavetable;
+    // Rendered here so the audio thread only ever reads finished tables
+    EnvelopeCurve curve;
+    curve.setPoints(points, wavetableResolution);
+    wavetables.publish(curve);
 }
 
-float Compressor::getCurrentGainReduction() const
+template <typename SampleType>
+void Compressor<SampleType>::setWavetableResolution(int numEntries)
 {
-    return currentGainReduction;
+    numEntries = juce::jlimit(EnvelopeCurve::minResolution, EnvelopeCurve::maxResolution, numEntries);
+    if (numEntries == wavetableResolution)
+        return;
+    
+    wavetableResolution = numEntries;
+    publishWavetable(attackWavetables, attackWavetables.getLatest().getPoints());
+    publishWavetable(releaseWavetables, releaseWavetables.getLatest().getPoints());
 }
 
-float Compressor::getCurrentInputLevel() const
+template <typename SampleType>
+void Compressor<SampleType>::setWavetableInterpolation(EnvelopeCurve::Interpolation newInterpolation)
 {
-    return currentInputLevel;
+    wavetableInterpolation = newInterpolation;
 }
 
-const std::array<float, 256>& Compressor::getGainReductionHistory() const
+template <typename SampleType>
+const std::array<float, 256>& Compressor<SampleType>::getAttackWavetable() const
+{
+    return attackWavetables.getLatest().getPoints();
+}
+
+template <typename SampleType>
+const std::array<float, 256>& Compressor<SampleType>::getReleaseWavetable() const
+{
+    return releaseWavetables.getLatest().getPoints();
+}
+
+template <typename SampleType>
+double Compressor<SampleType>::getWavetableSwapsPerSecond()
+{
+    return attackWavetables.getSwapsPerSecond() + releaseWavetables.getSwapsPerSecond();
+}
+
+template <typename SampleType>
+float Compressor<SampleType>::getCurrentGainReduction() const
+{
+    float deepest = 0.0f;
+    for (int groupIndex = 0; groupIndex < juce::jmin(numLinkGroups, static_cast<int>(linkGroups.size())); ++groupIndex)
+        deepest = juce::jmax(deepest, linkGroups[static_cast<size_t>(groupIndex)].currentGainReduction);
+    
+    return deepest;
+}
+
+template <typename SampleType>
+float Compressor<SampleType>::getCurrentInputLevel() const
+{
+    float loudest = -100.0f;
+    for (int groupIndex = 0; groupIndex < juce::jmin(numLinkGroups, static_cast<int>(linkGroups.size())); ++groupIndex)
+        loudest = juce::jmax(loudest, linkGroups[static_cast<size_t>(groupIndex)].currentInputLevel);
+    
+    return loudest;
+}
+
+template <typename SampleType>
+const std::array<float, 256>& Compressor<SampleType>::getGainReductionHistory() const
 {
     return gainReductionHistory;
-} 
\ No newline at end of file
+}
+
+template class Compressor<float>;
+template class Compressor<double>;
@@ -1,32 +1,115 @@
 #pragma once
 
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
 #include <array>
+#include <memory>
+#include <vector>
+#include "WavetableExchange.h"
+#include "EnvelopeCurve.h"
+#include "TransferCurve.h"
+#include "ParameterRamp.h"
+#include "SlidingWindowMax.h"
+#include "BlockDelayLine.h"
+#include "RmsDetector.h"
+#include "KeyFilter.h"
 
+// Runs on float or double audio. The audio path (oversampling, lookahead delay,
+// gain multiply) works at SampleType; the detector and gain computer always
+// run in float, so both precisions share the same vectorized kernels.
+template <typename SampleType>
 class Compressor
 {
 public:
+    // What the detector measures on the linked signal
+    enum class DetectorMode
+    {
+        peak,   // instantaneous peak
+        rms,    // windowed RMS
+        hybrid  // average of peak and RMS
+    };
+    
+    // How often the attack/release envelope is evaluated
+    enum class EnvelopeMode
+    {
+        perSample,  // every sample
+        eco         // updated once every few samples, with a linear ramp in between; RMS detector only
+    };
+    
     Compressor();
     ~Compressor() = default;
     
-    void prepare(double sampleRate, int samplesPerBlock);
-    void process(juce::AudioBuffer<float>& buffer);
+    // numKeyChannels is the most channels a detector input passed to process() will have
+    void prepare(double sampleRate, int samplesPerBlock, int numChannels = 2, int numKeyChannels = 2);
+    
+    // Clears the envelopes, detectors, delay and filter state; settings are kept
+    void reset();
+    
+    void process(juce::AudioBuffer<SampleType>& buffer);
+    void process(const juce::dsp::AudioBlock<SampleType>& block);
+    
+    // Compress buffer using detectorInput as the key (e.g. an external sidechain).
+    // detectorInput must have at least as many samples as buffer
+    void process(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>& detectorInput);
+    void process(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<const SampleType>& detectorInput);
+    
+    // Internal oversampling around the whole compressor: 0 = off, 1 = 2x, 2 = 4x, 3 = 8x.
+    // Takes effect at the start of the next block
+    static constexpr int maxOversamplingLog2 = 3;
+    void setOversamplingFactor(int factorLog2);
+    
+    // Lookahead: the audio is delayed and the detector sees it this far ahead.
+    // Takes effect at the start of the next block
+    static constexpr float maxLookaheadMs = 20.0f;
+    void setLookahead(float newLookaheadMs);
+    
+    // Channel linking: each channel shares its detector and gain with the other
+    // channels in its group. groupOfChannel holds a group index per channel,
+    // counting from 0; all zeros (the default) links every channel. Applies to the
+    // channels allocated in prepare(), so call it after prepare(). Does not allocate
+    void setLinkGroups(const int* groupOfChannel, int numChannels);
+    
+    // Which audio channel each channel of an external key stands for, or -1 for
+    // none; a key channel drives that audio channel's link group. A group left
+    // without a key channel of its own (e.g. the surrounds of a 5.1 bus keyed by
+    // a stereo sidechain) is keyed by every key channel. Key channel n stands for
+    // audio channel n by default. Call after prepare(). Does not allocate
+    void setKeyChannelMap(const int* audioChannelOfKeyChannel, int numKeyChannels);
+    
+    // Latency added by lookahead and the active oversampling filters, in host-rate samples
+    int getLatencySamples() const;
     
     // Getters and setters for parameters
     void setThreshold(float newThreshold);
     void setKnee(float newKnee);
+    void setRatio(float newRatio); // infinity for a limiter
+    void setDetectorMode(DetectorMode newMode);
+    void setEnvelopeMode(EnvelopeMode newMode);
+    
+    // Key filter on the detector input; KeyFilter<float>::minHighPassHz / maxLowPassHz turn them off
+    void setKeyHighPass(float frequencyHz);
+    void setKeyLowPass(float frequencyHz);
     void setInputGain(float newInputGain);
     void setOutputGain(float newOutputGain);
     void setAttackTime(float newAttackTimeSeconds);
     void setReleaseTime(float newReleaseTimeSeconds);
     
-    // Wavetable getters and setters
+    // Wavetable getters and setters (message thread). New tables are picked up
+    // by the audio thread at the start of the next block
     void setAttackWavetable(const std::array<float, 256>& wavetable);
     void setReleaseWavetable(const std::array<float, 256>& wavetable);
     
     const std::array<float, 256>& getAttackWavetable() const;
     const std::array<float, 256>& getReleaseWavetable() const;
     
+    // Table size the curves are rendered at (message thread), and how the audio
+    // thread reads between its entries
+    void setWavetableResolution(int numEntries);
+    void setWavetableInterpolation(EnvelopeCurve::Interpolation newInterpolation);
+    
+    // Wavetable swaps picked up by the audio thread per second, since the previous call
+    double getWavetableSwapsPerSecond();
+    
     // Get current gain reduction for visualization
     float getCurrentGainReduction() const;
     
@@ -37,36 +120,128 @@ public:
     const std::array<float, 256>& getGainReductionHistory() const;
     
 private:
-    float calculateGainReduction(float inputLevel);
-    void updateEnvelope(float inputLevel);
+    // Channels that share one detector and gain. Each group has its own envelope,
+    // RMS window, lookahead peak and scratch buffers
+    struct LinkGroup
+    {
+        float currentGainReduction = 0.0f;
+        float currentInputLevel = -100.0f;  // dB
+        float attackPhase = 0.0f;
+        float releasePhase = 0.0f;
+        bool inAttack = false;
+        bool inRelease = false;
+        
+        // Set per chunk when the group skips the gain computer and envelope
+        bool atRest = false;
+        
+        RmsDetector rmsDetector;
+        SlidingWindowMax lookaheadPeak;
+        
+        // Per-sample scratch, sized in prepare() for the highest oversampling factor
+        std::vector<float> detectorBuffer;  // linked peak, then target gain reduction (dB)
+        std::vector<float> gainBuffer;      // envelope gain reduction (dB), then linear gain
+    };
+    
+    void updateEnvelope(LinkGroup& group, float targetGainReduction);
+    void advanceEnvelope(LinkGroup& group, float targetGainReduction, int numSteps);
+    
+    void updateOversampling();
+    void updateLookahead();
+    void updatePhaseIncrements();
+    void publishWavetable(WavetableExchange<EnvelopeCurve>& wavetables, const EnvelopeCurve::Points& points);
+    
+    // detectorInput == nullptr keys the detector from the audio itself
+    void processBlock(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<const SampleType>* detectorInput);
+    
+    // Block pipeline, run once per chunk at the processing (oversampled) rate
+    // externalKey maps the key channels through keyChannelMap instead of one to one
+    void processChunk(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<SampleType>& key, bool externalKey);
+    void computeLinkedPeak(int groupIndex, const juce::dsp::AudioBlock<SampleType>& key, bool externalKey);
+    void computeTargetGainReduction(LinkGroup& group, int numSamples);
+    void runEnvelope(LinkGroup& group, int numSamples);
+    void runEnvelopeEco(LinkGroup& group, int numSamples);
+    template <int interval> void runEnvelopeControlRate(LinkGroup& group, int numSamples);
+    void updateHistory(int numSamples);
+    void updateHistoryAtRest(int numSamples);
+    void applyRestingGain(const juce::dsp::AudioBlock<SampleType>& block);
+    void gainReductionToGain(LinkGroup& group, int numSamples);
+    void applyGainToChannels(const juce::dsp::AudioBlock<SampleType>& block);
     
     // Parameters
     float threshold = 0.0f;    // dB
     float knee = 0.0f;         // dB
+    float ratio = 4.0f;        // x:1, may be infinity
     float inputGain = 0.0f;    // dB
     float outputGain = 0.0f;   // dB
     float attackTime = 0.01f;  // seconds
     float releaseTime = 0.1f;  // seconds
     
-    // Envelope follower state
-    float currentEnvelope = 0.0f;
-    float currentGainReduction = 0.0f;
-    float currentInputLevel = 0.0f;  // Current input level in dB
+    // Envelope phase advance per processing-rate sample, updated when the
+    // times or the processing rate change
+    float attackPhaseIncrement = 0.0f;
+    float releasePhaseIncrement = 0.0f;
     
-    // Wavetables
-    std::array<float, 256> attackWavetable;
-    std::array<float, 256> releaseWavetable;
+    // Smoothed per sample to avoid zipper noise under automation.
+    // Input and output gain ramp in the linear gain domain, threshold in dB
+    static constexpr double parameterRampSeconds = 0.05;
+    ParameterRamp inputGainRamp { 1.0f };
+    ParameterRamp outputGainRamp { 1.0f };
+    ParameterRamp thresholdRamp { 0.0f };
     
-    // Attack and release phase trackers
-    float attackPhase = 0.0f;
-    float releasePhase = 0.0f;
-    bool inAttack = false;
-    bool inRelease = false;
+    // Static curve relative to the threshold, recompiled when knee or ratio change.
+    // Levels are offset by the (ramped) threshold before the curve is evaluated
+    TransferCurve transferCurve;
+    
+    // Link groups; one per channel is allocated so any grouping fits
+    std::vector<LinkGroup> linkGroups;
+    std::vector<int> channelLinkGroup;  // group index of each channel
+    std::vector<int> keyChannelMap;     // audio channel of each external key channel, or -1
+    int numLinkGroups = 1;
+    
+    // Wavetables, handed over from the message thread without locks
+    WavetableExchange<EnvelopeCurve> attackWavetables;
+    WavetableExchange<EnvelopeCurve> releaseWavetables;
+    int wavetableResolution = EnvelopeCurve::defaultResolution;
+    EnvelopeCurve::Interpolation wavetableInterpolation = EnvelopeCurve::Interpolation::linear;
     
     // For visualization
     std::array<float, 256> gainReductionHistory;
     int historyIndex = 0;
+    int restingHistorySamples = 0;  // trailing zeros written while at rest
+    
+    // Below-knee margin for the at-rest check, well above the fast log's error
+    static constexpr float restMarginDb = 0.01f;
     
-    // Sample rate for time calculations
+    // Host sample rate, and the rate the pipeline runs at (host rate * oversampling)
     double sampleRate = 44100.0;
+    double processingRate = 44100.0;
+    
+    // Oversampling, one preallocated instance per factor (index 0 = off)
+    std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, maxOversamplingLog2 + 1> oversamplers;
+    int requestedOversamplingLog2 = 0;
+    int activeOversamplingLog2 = 0;
+    int oversamplingLatency = 0;
+    
+    // Detector key: filtered copy of the audio or the external sidechain, and its
+    // own upsamplers so it stays aligned with the oversampled audio
+    juce::AudioBuffer<SampleType> keyBuffer;
+    KeyFilter<SampleType> keyFilter;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, maxOversamplingLog2 + 1> keyOversamplers;
+    
+    // Detector mode; the RMS window runs at the processing rate
+    static constexpr double rmsWindowSeconds = 0.01;
+    DetectorMode detectorMode = DetectorMode::peak;
+    
+    // Eco envelope: one update per ecoInterval samples, picked from the
+    // processing rate so the control rate stays around 10 kHz
+    EnvelopeMode envelopeMode = EnvelopeMode::perSample;
+    int ecoInterval = 4;
+    
+    // Lookahead, running at the processing rate
+    float requestedLookaheadMs = 0.0f;
+    float activeLookaheadMs = -1.0f;
+    int lookaheadLatency = 0;
+    BlockDelayLine<SampleType> lookaheadDelay;
+    
+    int maxBlockSize = 0;
 }; 
\ No newline at end of file
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "Biquad.h"
+#include <array>
+#include <numeric>
+#include <vector>
+
+//==============================================================================
+// Splits a signal into up to maxBands bands with 4th-order Linkwitz-Riley
+// crossovers (two cascaded Butterworth sections per side), so the bands sum
+// back to an allpass of the input: flat magnitude, no comb filtering.
+//
+// Crossovers are applied as a tree from the lowest frequency up. Every band
+// already split off below crossover k goes through the allpass that the
+// low/high pair at k sums to, so all bands keep the same phase response.
+//
+// Every band has a run of slots, one per channel, and the lanes of a
+// juce::dsp::SIMDRegister run over the slots of all bands and channels
+// together, each lane with its own coefficients. A band's slots carry the
+// signal above the crossovers until its own crossover splits it off (allpass
+// below, low-pass at, high-pass above the band), so no sample ever moves
+// between lanes and each register runs through every crossover while it stays
+// in a CPU register. A register whose bands are all still above a crossover
+// would repeat the high-pass work of the previous register with the same
+// channels, so it starts from that register's signal instead.
+//
+// Runs are packed back to back when that fills the lanes with fewer sections,
+// and otherwise padded to whole registers, where the sharing above reduces to
+// the plain crossover tree. Each chain of registers with the same channels
+// runs through the block in a single pass, with all its filter state staying
+// in cache.
+template <typename SampleType>
+class CrossoverNetwork
+{
+public:
+    static constexpr int maxBands = 5;
+    static constexpr int maxCrossovers = maxBands - 1;
+
+    void prepare(double newSampleRate, int newNumChannels)
+    {
+        sampleRate = newSampleRate;
+        numChannels = juce::jmax(1, newNumChannels);
+
+        // Room for every band in the padded layout, the larger of the two
+        const auto maxRegisters = static_cast<size_t>(maxBands * paddedStride() / lanes);
+        registers.assign(maxRegisters, RegisterSections {});
+        inputChannels.assign(static_cast<size_t>(numChannels), nullptr);
+        bandChannels.assign(static_cast<size_t>(maxBands * numChannels), nullptr);
+
+        chooseLayout();
+    }
+
+    void reset()
+    {
+        for (auto& sections : registers)
+            for (auto& state : sections.states)
+                state.reset();
+    }
+
+    // 1 passes the input through as a single band
+    void setNumBands(int newNumBands)
+    {
+        newNumBands = juce::jlimit(1, maxBands, newNumBands);
+        if (newNumBands == numBands)
+            return;
+
+        // Filters that were idle hold stale state; start the new layout clean.
+        // Before prepare() there is nothing to lay out yet
+        numBands = newNumBands;
+        reset();
+        if (! registers.empty())
+            chooseLayout();
+    }
+
+    int getNumBands() const { return numBands; }
+
+    // Crossover index sits between band index and band index + 1. Frequencies
+    // must rise with the index; MultibandCompressor enforces the order
+    void setCrossoverFrequency(int index, float frequencyHz)
+    {
+        jassert(juce::isPositiveAndBelow(index, maxCrossovers));
+        auto& crossover = crossovers[static_cast<size_t>(index)];
+        if (frequencyHz == crossover.frequency)
+            return;
+
+        crossover.frequency = frequencyHz;
+        updateCrossover(index);
+    }
+
+    // Split input into bands[0 .. numBands - 1]. Each band block must have the
+    // input's size and must not alias it
+    void process(const juce::dsp::AudioBlock<const SampleType>& input,
+                 const std::array<juce::dsp::AudioBlock<SampleType>, maxBands>& bands)
+    {
+        const auto channelsToProcess = juce::jmin(static_cast<int>(input.getNumChannels()), numChannels);
+        const auto numSamples = static_cast<int>(input.getNumSamples());
+        const int numCrossovers = numBands - 1;
+
+        if (numCrossovers == 0)
+        {
+            bands[0].getSubsetChannelBlock(0, static_cast<size_t>(channelsToProcess))
+                .copyFrom(input.getSubsetChannelBlock(0, static_cast<size_t>(channelsToProcess)));
+            return;
+        }
+
+        // Channels from channelsToProcess up read silence and are not written
+        for (int channel = 0; channel < numChannels; ++channel)
+            inputChannels[static_cast<size_t>(channel)] = channel < channelsToProcess
+                ? input.getChannelPointer(static_cast<size_t>(channel)) : nullptr;
+
+        for (int band = 0; band < numBands; ++band)
+            for (int channel = 0; channel < numChannels; ++channel)
+                bandChannels[static_cast<size_t>(band * numChannels + channel)] = channel < channelsToProcess
+                    ? bands[static_cast<size_t>(band)].getChannelPointer(static_cast<size_t>(channel)) : nullptr;
+
+        const int numRegisters = numRegistersFor(numBands);
+
+        for (int chain = 0; chain < juce::jmin(chainPeriod, numRegisters); ++chain)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                for (int index = chain; index < numRegisters; index += chainPeriod)
+                {
+                    auto& sections = registers[static_cast<size_t>(index)];
+                    const auto x = sections.firstCrossover < 0
+                        ? sections.gather(inputChannels.data(), i)
+                        : registers[static_cast<size_t>(index - chainPeriod)].inputs[static_cast<size_t>(sections.firstCrossover)];
+
+                    sections.scatter(sections.process(x, numCrossovers), i);
+                }
+            }
+        }
+    }
+
+private:
+    using Vector = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int lanes = static_cast<int>(Vector::size());
+
+    int numRegistersFor(int bands) const { return (bands * bandStride + lanes - 1) / lanes; }
+    int paddedStride() const { return (numChannels + lanes - 1) / lanes * lanes; }
+    int bandOfSlot(int slot) const { return slot / bandStride; }
+    int channelOfSlot(int slot) const { return slot % bandStride; }  // numChannels and up is padding
+
+    // One section per lane
+    struct LaneCoefficients
+    {
+        Vector b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+    };
+
+    // Both sections of every crossover for the lanes of one register
+    struct RegisterSections
+    {
+        // Builds the register from broadcasts of the input, since loading it
+        // from scalar stores would stall
+        Vector gather(const SampleType* const* channels, int i) const
+        {
+            Vector x {};
+            for (size_t index = 0; index < numGatherChannels; ++index)
+                if (const auto* channel = channels[gatherChannels[index]])
+                    x = x + Vector::expand(channel[i]) * gatherMasks[index];
+
+            return x;
+        }
+
+        Vector process(Vector x, int numCrossovers)
+        {
+            for (int k = juce::jmax(0, firstCrossover); k < numCrossovers; ++k)
+            {
+                const auto first = static_cast<size_t>(2 * k);
+                if ((sharedInputs & (1 << k)) != 0)
+                    inputs[static_cast<size_t>(k)] = x;
+
+                x = states[first].processSample(coefficients[first], x);
+
+                if (k < numSecondSections)
+                    x = states[first + 1].processSample(coefficients[first + 1], x);
+            }
+
+            if ((sharedInputs & (1 << numCrossovers)) != 0)
+                inputs[static_cast<size_t>(numCrossovers)] = x;
+
+            return x;
+        }
+
+        void scatter(Vector x, int i)
+        {
+            x.copyToRawArray(output);
+            for (size_t index = 0; index < numScatterLanes; ++index)
+                if (auto* destination = *scatterChannels[index])
+                    destination[i] = output[scatterLanes[index]];
+        }
+
+        std::array<LaneCoefficients, 2 * maxCrossovers> coefficients {};
+        std::array<BiquadState<Vector>, 2 * maxCrossovers> states {};
+
+        // The signal entering crossover k, kept when bit k of sharedInputs is
+        // set because the next register of the chain starts from it
+        std::array<Vector, maxCrossovers + 1> inputs {};
+        int sharedInputs = 0;
+
+        // Where the register starts from the previous one of its chain, or
+        // -1 to start from the input
+        int firstCrossover = -1;
+
+        // The bands below a crossover only take its first section
+        int numSecondSections = 0;
+
+        std::array<int, lanes> gatherChannels {};
+        std::array<Vector, lanes> gatherMasks {};
+        size_t numGatherChannels = 0;
+
+        // Lanes holding a band's channel, and where the band pointer for it lives
+        alignas(alignof(Vector)) SampleType output[lanes] {};
+        std::array<int, lanes> scatterLanes {};
+        std::array<SampleType* const*, lanes> scatterChannels {};
+        size_t numScatterLanes = 0;
+    };
+
+    struct Crossover
+    {
+        float frequency = 1000.0f;
+    };
+
+    // Plans both layouts for the current band count and keeps the one that
+    // runs fewer sections per sample
+    void chooseLayout()
+    {
+        bandStride = numChannels;
+        const int packedSections = planLayout();
+
+        bandStride = paddedStride();
+        if (planLayout() > packedSections)
+        {
+            bandStride = numChannels;
+            planLayout();
+        }
+
+        for (int index = 0; index < maxCrossovers; ++index)
+            updateCrossover(index);
+    }
+
+    int planLayout()
+    {
+        // Registers chainPeriod apart have the same channel in every lane
+        chainPeriod = bandStride / std::gcd(bandStride, lanes);
+
+        const int numCrossovers = numBands - 1;
+        int numSections = 0;
+
+        for (auto& sections : registers)
+            sections.sharedInputs = 0;
+
+        for (int index = 0; index < numRegistersFor(numBands); ++index)
+        {
+            planRegister(index);
+
+            const auto& sections = registers[static_cast<size_t>(index)];
+            for (int k = juce::jmax(0, sections.firstCrossover); k < numCrossovers; ++k)
+                numSections += k < sections.numSecondSections ? 2 : 1;
+        }
+
+        return numSections;
+    }
+
+    void planRegister(int index)
+    {
+        auto& sections = registers[static_cast<size_t>(index)];
+        const int firstSlot = index * lanes;
+        sections.numSecondSections = bandOfSlot(firstSlot + lanes - 1) + 1;
+
+        // The previous register of the chain has lower bands; the crossovers
+        // below its lowest band are high-pass for both. With none shared it
+        // still saves gathering the input again
+        sections.firstCrossover = -1;
+        if (index >= chainPeriod)
+        {
+            sections.firstCrossover = bandOfSlot((index - chainPeriod) * lanes);
+            registers[static_cast<size_t>(index - chainPeriod)].sharedInputs |= 1 << sections.firstCrossover;
+        }
+
+        // One broadcast per channel present, masked to its lanes
+        alignas(alignof(Vector)) SampleType mask[lanes];
+        sections.numGatherChannels = 0;
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            bool present = false;
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                mask[lane] = channelOfSlot(firstSlot + lane) == channel ? 1 : 0;
+                present = present || mask[lane] != 0;
+            }
+
+            if (present)
+            {
+                sections.gatherChannels[sections.numGatherChannels] = channel;
+                sections.gatherMasks[sections.numGatherChannels] = Vector::fromRawArray(mask);
+                ++sections.numGatherChannels;
+            }
+        }
+
+        sections.numScatterLanes = 0;
+        for (int lane = 0; lane < lanes; ++lane)
+        {
+            const int band = bandOfSlot(firstSlot + lane);
+            const int channel = channelOfSlot(firstSlot + lane);
+            if (band >= numBands || channel >= numChannels)
+                continue;
+
+            sections.scatterLanes[sections.numScatterLanes] = lane;
+            sections.scatterChannels[sections.numScatterLanes] = &bandChannels[static_cast<size_t>(band * numChannels + channel)];
+            ++sections.numScatterLanes;
+        }
+    }
+
+    // Picks both sections of a crossover for every slot and packs them into
+    // the registers: allpass below, low-pass at and high-pass above the band
+    // it splits off
+    void updateCrossover(int index)
+    {
+        const auto frequency = static_cast<double>(crossovers[static_cast<size_t>(index)].frequency);
+        const auto lowPass = BiquadCoefficients<SampleType>::makeLowPass(sampleRate, frequency);
+        const auto highPass = BiquadCoefficients<SampleType>::makeHighPass(sampleRate, frequency);
+        const auto allPass = BiquadCoefficients<SampleType>::makeAllPass(sampleRate, frequency);
+        const BiquadCoefficients<SampleType> passThrough;
+
+        auto sectionForSlot = [&](int slot, int section) -> const BiquadCoefficients<SampleType>&
+        {
+            const int band = bandOfSlot(slot);
+            if (band < index)
+                return section == 0 ? allPass : passThrough;
+
+            return band == index ? lowPass : highPass;
+        };
+
+        alignas(alignof(Vector)) SampleType b0[lanes], b1[lanes], b2[lanes], a1[lanes], a2[lanes];
+
+        for (size_t registerIndex = 0; registerIndex < registers.size(); ++registerIndex)
+        {
+            for (int section = 0; section < 2; ++section)
+            {
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    const auto& coefficients = sectionForSlot(static_cast<int>(registerIndex) * lanes + lane, section);
+                    b0[lane] = coefficients.b0;
+                    b1[lane] = coefficients.b1;
+                    b2[lane] = coefficients.b2;
+                    a1[lane] = coefficients.a1;
+                    a2[lane] = coefficients.a2;
+                }
+
+                auto& packed = registers[registerIndex].coefficients[static_cast<size_t>(2 * index + section)];
+                packed.b0 = Vector::fromRawArray(b0);
+                packed.b1 = Vector::fromRawArray(b1);
+                packed.b2 = Vector::fromRawArray(b2);
+                packed.a1 = Vector::fromRawArray(a1);
+                packed.a2 = Vector::fromRawArray(a2);
+            }
+        }
+    }
+
+    double sampleRate = 44100.0;
+    int numChannels = 1;
+    int numBands = 1;
+    int bandStride = 1;   // slots per band
+    int chainPeriod = 1;  // registers from one to the next with the same channels
+    std::array<Crossover, maxCrossovers> crossovers;
+    std::vector<RegisterSections> registers;
+    std::vector<const SampleType*> inputChannels;
+    std::vector<SampleType*> bandChannels;
+};
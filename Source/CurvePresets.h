@@ -0,0 +1,79 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cmath>
+#include "EnvelopeCurve.h"
+
+//==============================================================================
+// The preset attack/release curve shapes offered by the wavetable editor.
+// Kept free of GUI code so the offline renderer builds the same curves.
+namespace CurvePresets
+{
+    enum class Shape
+    {
+        linear,       // straight line
+        exponential,  // starts slow, accelerates
+        logarithmic,  // starts fast, slows down
+        sCurve        // sigmoid
+    };
+
+    inline constexpr int numShapes = 4;
+
+    inline const char* getName(Shape shape)
+    {
+        switch (shape)
+        {
+            case Shape::linear:      return "linear";
+            case Shape::exponential: return "exponential";
+            case Shape::logarithmic: return "logarithmic";
+            case Shape::sCurve:      return "s-curve";
+        }
+
+        return "";
+    }
+
+    // Attack curves run from 0 to 1, release curves from 1 to 0
+    inline EnvelopeCurve::Points make(Shape shape, bool isRelease)
+    {
+        EnvelopeCurve::Points points;
+        const float startValue = isRelease ? 1.0f : 0.0f;
+        const float endValue = isRelease ? 0.0f : 1.0f;
+        const float range = endValue - startValue;
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const float normalizedPos = static_cast<float>(i) / static_cast<float>(points.size() - 1);
+            float curveValue = normalizedPos;
+
+            switch (shape)
+            {
+                case Shape::linear:
+                    break;
+
+                case Shape::exponential:
+                    // x^2 gives a slower start; 1 - x^2 for release
+                    curveValue = isRelease ? 1.0f - std::pow(normalizedPos, 2.0f) : std::pow(normalizedPos, 2.0f);
+                    break;
+
+                case Shape::logarithmic:
+                    // sqrt gives a faster start
+                    curveValue = isRelease ? std::sqrt(1.0f - normalizedPos) : std::sqrt(normalizedPos);
+                    break;
+
+                case Shape::sCurve:
+                {
+                    // Sigmoid: 1 / (1 + e^(-k * (x - 0.5)))
+                    const float k = 10.0f; // Steepness of S-curve
+                    curveValue = 1.0f / (1.0f + std::exp(-k * (normalizedPos - 0.5f)));
+                    if (isRelease)
+                        curveValue = 1.0f - curveValue;
+                    break;
+                }
+            }
+
+            points[i] = startValue + curveValue * range;
+        }
+
+        return points;
+    }
+}
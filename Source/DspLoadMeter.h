@@ -0,0 +1,131 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+// How much of each block's time budget (numSamples / sampleRate) processing
+// takes, as a fraction: 1.0 means the block took as long as it lasts.
+//
+// The audio thread times every block with the high-resolution tick counter
+// and adds it to a histogram of 1% wide bins; anything over the last bin
+// lands in it. Counters are relaxed atomics with the audio thread as the only
+// writer, so timing a block never locks and reading never blocks the audio.
+class DspLoadMeter
+{
+public:
+    static constexpr int numBins = 512;
+    static constexpr double binWidth = 0.01;
+
+    struct Statistics
+    {
+        double p50 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+        double latest = 0.0;    // the last block's load
+        juce::int64 numBlocks = 0;
+    };
+
+    // Times a block for as long as it exists
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(DspLoadMeter& meterToUse, int numSamplesInBlock) noexcept
+            : meter(meterToUse), numSamples(numSamplesInBlock), startTicks(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedTimer() noexcept
+        {
+            meter.addBlock(juce::Time::getHighResolutionTicks() - startTicks, numSamples);
+        }
+
+    private:
+        DspLoadMeter& meter;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+    // Call before processing starts; the statistics start over
+    void prepare(double sampleRate)
+    {
+        ticksPerSample.store(static_cast<double>(juce::Time::getHighResolutionTicksPerSecond()) / sampleRate, std::memory_order_relaxed);
+        reset();
+    }
+
+    // Safe from any thread. A block finishing at the same moment may be lost
+    void reset() noexcept
+    {
+        for (auto& bin : bins)
+            bin.store(0, std::memory_order_relaxed);
+
+        maxLoad.store(0.0, std::memory_order_relaxed);
+        latestLoad.store(0.0, std::memory_order_relaxed);
+    }
+
+    // Audio thread only
+    void addBlock(juce::int64 elapsedTicks, int numSamples) noexcept
+    {
+        const auto budget = static_cast<double>(numSamples) * ticksPerSample.load(std::memory_order_relaxed);
+        if (budget <= 0.0)
+            return;
+
+        const auto load = static_cast<double>(elapsedTicks) / budget;
+        const auto bin = juce::jlimit(0, numBins - 1, static_cast<int>(load / binWidth));
+        bins[static_cast<size_t>(bin)].fetch_add(1, std::memory_order_relaxed);
+
+        latestLoad.store(load, std::memory_order_relaxed);
+        if (load > maxLoad.load(std::memory_order_relaxed))
+            maxLoad.store(load, std::memory_order_relaxed);
+    }
+
+    // Percentiles are the upper edge of the bin they fall in, capped at the
+    // maximum, so they read at most 1% high and never low
+    Statistics getStatistics() const noexcept
+    {
+        std::array<juce::uint32, numBins> counts;
+        juce::int64 total = 0;
+
+        for (size_t bin = 0; bin < counts.size(); ++bin)
+        {
+            counts[bin] = bins[bin].load(std::memory_order_relaxed);
+            total += counts[bin];
+        }
+
+        Statistics statistics;
+        statistics.numBlocks = total;
+        statistics.max = maxLoad.load(std::memory_order_relaxed);
+        statistics.latest = latestLoad.load(std::memory_order_relaxed);
+
+        if (total == 0)
+            return statistics;
+
+        auto getPercentile = [&](double fraction)
+        {
+            const auto target = static_cast<juce::int64>(std::ceil(fraction * static_cast<double>(total)));
+            juce::int64 count = 0;
+
+            for (size_t bin = 0; bin < counts.size(); ++bin)
+            {
+                count += counts[bin];
+                if (count >= target)
+                    return juce::jmin(static_cast<double>(bin + 1) * binWidth, statistics.max);
+            }
+
+            return statistics.max;
+        };
+
+        statistics.p50 = getPercentile(0.5);
+        statistics.p99 = getPercentile(0.99);
+        return statistics;
+    }
+
+private:
+    std::array<std::atomic<juce::uint32>, numBins> bins {};
+    std::atomic<double> maxLoad { 0.0 };
+    std::atomic<double> latestLoad { 0.0 };
+    std::atomic<double> ticksPerSample { 0.0 };
+};
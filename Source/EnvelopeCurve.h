@@ -0,0 +1,104 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+
+//==============================================================================
+// An attack or release curve: the editor's 256 points, rendered into a denser
+// table that the audio thread reads with interpolation.
+//
+// Attack and release use the same layout and lookup. The table starts on a
+// cache line and carries one guard point before the curve and two after it, so
+// a cubic read at any phase in 0..1 never needs a bounds check.
+class EnvelopeCurve
+{
+public:
+    static constexpr int numPoints = 256;  // editor resolution
+    static constexpr int minResolution = 256;
+    static constexpr int maxResolution = 4096;
+    static constexpr int defaultResolution = 1024;
+
+    using Points = std::array<float, numPoints>;
+
+    enum class Interpolation
+    {
+        linear,
+        cubic  // Catmull-Rom
+    };
+
+    // Message thread: keep the points and render them into `newResolution` table
+    // entries (clamped to minResolution..maxResolution)
+    void setPoints(const Points& newPoints, int newResolution)
+    {
+        points = newPoints;
+        resolution = juce::jlimit(minResolution, maxResolution, newResolution);
+        lastIndex = static_cast<float>(resolution - 1);
+
+        // Resample with the same cubic the audio thread uses, clamped so the
+        // overshoot never pushes a curve value outside 0..1
+        const float pointsPerEntry = static_cast<float>(numPoints - 1) / lastIndex;
+        for (int i = 0; i < resolution; ++i)
+        {
+            const float position = static_cast<float>(i) * pointsPerEntry;
+            const int index = juce::jmin(static_cast<int>(position), numPoints - 2);
+
+            const float value = interpolateCubic(getPointOrExtrapolate(index - 1), points[static_cast<size_t>(index)],
+                                                 points[static_cast<size_t>(index + 1)], getPointOrExtrapolate(index + 2),
+                                                 position - static_cast<float>(index));
+
+            table[static_cast<size_t>(guardPoints + i)] = juce::jlimit(0.0f, 1.0f, value);
+        }
+
+        // Guard points continue the end slopes, so the cubic stays accurate at
+        // phase 0 and 1
+        const auto first = static_cast<size_t>(guardPoints);
+        const auto last = static_cast<size_t>(guardPoints + resolution - 1);
+        table[0] = 2.0f * table[first] - table[first + 1];
+        table[last + 1] = 2.0f * table[last] - table[last - 1];
+        table[last + 2] = 3.0f * table[last] - 2.0f * table[last - 1];
+    }
+
+    const Points& getPoints() const { return points; }
+    int getResolution() const { return resolution; }
+
+    // Audio thread: curve value at phase 0..1
+    float lookUp(float phase, Interpolation interpolation) const
+    {
+        const float position = juce::jlimit(0.0f, 1.0f, phase) * lastIndex;
+        const int index = static_cast<int>(position);
+        const float fraction = position - static_cast<float>(index);
+        const float* entry = table.data() + guardPoints + index;
+
+        if (interpolation == Interpolation::cubic)
+            return juce::jlimit(0.0f, 1.0f, interpolateCubic(entry[-1], entry[0], entry[1], entry[2], fraction));
+
+        return entry[0] + fraction * (entry[1] - entry[0]);
+    }
+
+private:
+    static float interpolateCubic(float previous, float from, float to, float next, float fraction)
+    {
+        const float a = 0.5f * (next - previous) + 1.5f * (from - to);
+        const float b = previous - 2.5f * from + 2.0f * to - 0.5f * next;
+        const float c = 0.5f * (to - previous);
+        return ((a * fraction + b) * fraction + c) * fraction + from;
+    }
+
+    float getPointOrExtrapolate(int index) const
+    {
+        if (index < 0)
+            return 2.0f * points.front() - points[1];
+
+        if (index >= numPoints)
+            return 2.0f * points.back() - points[numPoints - 2];
+
+        return points[static_cast<size_t>(index)];
+    }
+
+    static constexpr int guardPoints = 1;
+
+    alignas(64) std::array<float, maxResolution + 3> table {};
+    Points points {};
+    int resolution = minResolution;
+    float lastIndex = static_cast<float>(minResolution - 1);
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "Biquad.h"
+#include <vector>
+
+//==============================================================================
+// High-pass / low-pass filter for the detector key: one Butterworth biquad
+// per side, so each slopes at 12 dB/oct.
+//
+// Coefficients are computed in place when a frequency changes, so nothing
+// allocates on the audio thread (juce::dsp::IIR::Coefficients would).
+// Channels are packed into the lanes of a juce::dsp::SIMDRegister, as in
+// CrossoverNetwork, and both sections run in a single pass over the block.
+// Filter state is kept at SampleType between blocks.
+template <typename SampleType>
+class KeyFilter
+{
+public:
+    static constexpr float minHighPassHz = 20.0f;   // at or below: high-pass off
+    static constexpr float maxLowPassHz = 20000.0f; // at or above: low-pass off
+
+    void prepare(double newSampleRate, int newNumChannels)
+    {
+        sampleRate = newSampleRate;
+        numChannels = juce::jmax(1, newNumChannels);
+        groups.assign(static_cast<size_t>((numChannels + lanes - 1) / lanes), {});
+        updateHighPass();
+        updateLowPass();
+    }
+
+    void reset()
+    {
+        std::fill(groups.begin(), groups.end(), GroupState {});
+    }
+
+    void setHighPassFrequency(float newFrequency)
+    {
+        if (newFrequency == highPassFrequency)
+            return;
+
+        highPassFrequency = newFrequency;
+        updateHighPass();
+    }
+
+    void setLowPassFrequency(float newFrequency)
+    {
+        if (newFrequency == lowPassFrequency)
+            return;
+
+        lowPassFrequency = newFrequency;
+        updateLowPass();
+    }
+
+    bool isActive() const { return highPassActive || lowPassActive; }
+
+    // Filter every channel of the block in place
+    void process(const juce::dsp::AudioBlock<SampleType>& block)
+    {
+        if (! isActive())
+            return;
+
+        const auto channelsToProcess = juce::jmin(static_cast<int>(block.getNumChannels()), numChannels);
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+
+        for (int firstChannel = 0; firstChannel < channelsToProcess; firstChannel += lanes)
+        {
+            const int groupChannels = juce::jmin(lanes, channelsToProcess - firstChannel);
+
+            SampleType* data[lanes] {};
+            for (int lane = 0; lane < groupChannels; ++lane)
+                data[lane] = block.getChannelPointer(static_cast<size_t>(firstChannel + lane));
+
+            processGroup(groups[static_cast<size_t>(firstChannel / lanes)], data, groupChannels, numSamples);
+        }
+    }
+
+private:
+    using Vector = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int lanes = static_cast<int>(Vector::size());
+
+    // Filter state for one group of channels
+    struct GroupState
+    {
+        BiquadState<Vector> highPass {}, lowPass {};
+    };
+
+    void processGroup(GroupState& state, SampleType* (&data)[lanes], int groupChannels, int numSamples)
+    {
+        alignas(alignof(Vector)) SampleType frame[lanes] {};
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Gather one sample from every channel of the group into the lanes
+            for (int lane = 0; lane < groupChannels; ++lane)
+                frame[lane] = data[lane][i];
+
+            auto x = Vector::fromRawArray(frame);
+
+            if (highPassActive)
+                x = state.highPass.processSample(highPass, x);
+
+            if (lowPassActive)
+                x = state.lowPass.processSample(lowPass, x);
+
+            x.copyToRawArray(frame);
+            for (int lane = 0; lane < groupChannels; ++lane)
+                data[lane][i] = frame[lane];
+        }
+    }
+
+    // A section that was off holds stale state, so it starts clean when it comes on
+    void updateHighPass()
+    {
+        const bool wasActive = highPassActive;
+        highPassActive = highPassFrequency > minHighPassHz;
+        if (! highPassActive)
+            return;
+
+        highPass = BiquadCoefficients<SampleType>::makeHighPass(sampleRate, highPassFrequency);
+        if (! wasActive)
+            for (auto& group : groups)
+                group.highPass.reset();
+    }
+
+    void updateLowPass()
+    {
+        const bool wasActive = lowPassActive;
+        lowPassActive = lowPassFrequency < maxLowPassHz && lowPassFrequency < sampleRate * 0.49;
+        if (! lowPassActive)
+            return;
+
+        lowPass = BiquadCoefficients<SampleType>::makeLowPass(sampleRate, lowPassFrequency);
+        if (! wasActive)
+            for (auto& group : groups)
+                group.lowPass.reset();
+    }
+
+    double sampleRate = 44100.0;
+    int numChannels = 1;
+    float highPassFrequency = minHighPassHz;
+    float lowPassFrequency = maxLowPassHz;
+    bool highPassActive = false;
+    bool lowPassActive = false;
+    BiquadCoefficients<SampleType> highPass, lowPass;
+    std::vector<GroupState> groups;
+};
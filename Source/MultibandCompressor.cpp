@@ -0,0 +1,303 @@
+#include "MultibandCompressor.h"
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::prepare(double sampleRate, int samplesPerBlock, int newNumChannels, int numKeyChannels)
+{
+    numChannels = juce::jmax(1, newNumChannels);
+    chunkSize = juce::jlimit(1, maxChunkSize, samplesPerBlock);
+
+    bandBuffer.setSize(maxBands * numChannels, chunkSize);
+    crossover.prepare(sampleRate, numChannels);
+    crossover.setNumBands(numBands);
+    crossover.reset();
+    updateCrossovers();
+
+    // The bands only ever see one chunk at a time
+    for (auto& band : bands)
+        band.prepare(sampleRate, chunkSize, numChannels, numKeyChannels);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::process(juce::AudioBuffer<SampleType>& buffer)
+{
+    processBlock(juce::dsp::AudioBlock<SampleType>(buffer), nullptr);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::process(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>& detectorInput)
+{
+    const juce::dsp::AudioBlock<const SampleType> detectorBlock(detectorInput);
+    processBlock(juce::dsp::AudioBlock<SampleType>(buffer), &detectorBlock);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::processBlock(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<const SampleType>* detectorInput)
+{
+    const auto channelsToProcess = juce::jmin(block.getNumChannels(), static_cast<size_t>(numChannels));
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    jassert(chunkSize > 0); // prepare() must be called before process()
+    if (channelsToProcess == 0 || chunkSize == 0)
+        return;
+
+    const juce::dsp::AudioBlock<SampleType> bandStorage(bandBuffer);
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto chunkStart = static_cast<size_t>(start);
+        const auto chunkLength = static_cast<size_t>(juce::jmin(chunkSize, numSamples - start));
+        auto chunk = block.getSubsetChannelBlock(0, channelsToProcess).getSubBlock(chunkStart, chunkLength);
+
+        std::array<juce::dsp::AudioBlock<SampleType>, maxBands> bandBlocks;
+        for (int band = 0; band < numBands; ++band)
+            bandBlocks[static_cast<size_t>(band)] = bandStorage
+                .getSubsetChannelBlock(static_cast<size_t>(band * numChannels), channelsToProcess)
+                .getSubBlock(0, chunkLength);
+
+        // 1. Split into bands (single pass over the chunk)
+        crossover.process(chunk, bandBlocks);
+
+        // 2. Compress each band in place
+        for (int band = 0; band < numBands; ++band)
+        {
+            auto& compressor = bands[static_cast<size_t>(band)];
+            const auto& bandBlock = bandBlocks[static_cast<size_t>(band)];
+
+            if (detectorInput == nullptr)
+                compressor.process(bandBlock);
+            else
+                compressor.process(bandBlock, detectorInput->getSubBlock(chunkStart, chunkLength));
+        }
+
+        // 3. Sum the bands back into the output
+        chunk.copyFrom(bandBlocks[0]);
+        for (int band = 1; band < numBands; ++band)
+            chunk.add(bandBlocks[static_cast<size_t>(band)]);
+    }
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setNumBands(int newNumBands)
+{
+    newNumBands = juce::jlimit(1, maxBands, newNumBands);
+    if (newNumBands == numBands)
+        return;
+
+    // An idle band still holds the envelope and filter state it stopped with
+    for (int band = numBands; band < newNumBands; ++band)
+        bands[static_cast<size_t>(band)].reset();
+
+    numBands = newNumBands;
+    crossover.setNumBands(numBands);
+    updateCrossovers();
+}
+
+template <typename SampleType>
+int MultibandCompressor<SampleType>::getNumBands() const
+{
+    return numBands;
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setCrossoverFrequency(int index, float frequencyHz)
+{
+    jassert(juce::isPositiveAndBelow(index, maxBands - 1));
+    requestedCrossovers[static_cast<size_t>(index)] = frequencyHz;
+    updateCrossovers();
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::updateCrossovers()
+{
+    // Out-of-order crossovers would split off bands with a negative width, so
+    // each one is pushed above the one below it, then all are pulled back
+    // under the top of the range
+    const int numCrossovers = numBands - 1;
+    std::array<float, maxBands - 1> frequencies {};
+
+    for (int index = 0; index < numCrossovers; ++index)
+    {
+        auto frequency = juce::jlimit(minCrossoverHz, maxCrossoverHz, requestedCrossovers[static_cast<size_t>(index)]);
+        if (index > 0)
+            frequency = juce::jmax(frequency, frequencies[static_cast<size_t>(index - 1)] * minCrossoverRatio);
+
+        frequencies[static_cast<size_t>(index)] = frequency;
+    }
+
+    for (int index = numCrossovers - 1; index >= 0; --index)
+    {
+        const auto limit = index == numCrossovers - 1 ? maxCrossoverHz
+                                                      : frequencies[static_cast<size_t>(index + 1)] / minCrossoverRatio;
+        auto& frequency = frequencies[static_cast<size_t>(index)];
+        frequency = juce::jmin(frequency, limit);
+        crossover.setCrossoverFrequency(index, frequency);
+    }
+}
+
+template <typename SampleType>
+Compressor<SampleType>& MultibandCompressor<SampleType>::getBand(int index)
+{
+    jassert(juce::isPositiveAndBelow(index, maxBands));
+    return bands[static_cast<size_t>(index)];
+}
+
+template <typename SampleType>
+const Compressor<SampleType>& MultibandCompressor<SampleType>::getBand(int index) const
+{
+    jassert(juce::isPositiveAndBelow(index, maxBands));
+    return bands[static_cast<size_t>(index)];
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setOversamplingFactor(int factorLog2)
+{
+    for (auto& band : bands)
+        band.setOversamplingFactor(factorLog2);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setLookahead(float newLookaheadMs)
+{
+    for (auto& band : bands)
+        band.setLookahead(newLookaheadMs);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setKnee(float newKnee)
+{
+    for (auto& band : bands)
+        band.setKnee(newKnee);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setRatio(float newRatio)
+{
+    for (auto& band : bands)
+        band.setRatio(newRatio);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setDetectorMode(typename Compressor<SampleType>::DetectorMode newMode)
+{
+    for (auto& band : bands)
+        band.setDetectorMode(newMode);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setEnvelopeMode(typename Compressor<SampleType>::EnvelopeMode newMode)
+{
+    for (auto& band : bands)
+        band.setEnvelopeMode(newMode);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setKeyHighPass(float frequencyHz)
+{
+    for (auto& band : bands)
+        band.setKeyHighPass(frequencyHz);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setKeyLowPass(float frequencyHz)
+{
+    for (auto& band : bands)
+        band.setKeyLowPass(frequencyHz);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setInputGain(float newInputGain)
+{
+    for (auto& band : bands)
+        band.setInputGain(newInputGain);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setOutputGain(float newOutputGain)
+{
+    for (auto& band : bands)
+        band.setOutputGain(newOutputGain);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setLinkGroups(const int* groupOfChannel, int newNumChannels)
+{
+    for (auto& band : bands)
+        band.setLinkGroups(groupOfChannel, newNumChannels);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setKeyChannelMap(const int* audioChannelOfKeyChannel, int numKeyChannels)
+{
+    for (auto& band : bands)
+        band.setKeyChannelMap(audioChannelOfKeyChannel, numKeyChannels);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setAttackWavetable(const std::array<float, 256>& wavetable)
+{
+    for (auto& band : bands)
+        band.setAttackWavetable(wavetable);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setReleaseWavetable(const std::array<float, 256>& wavetable)
+{
+    for (auto& band : bands)
+        band.setReleaseWavetable(wavetable);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setWavetableResolution(int numEntries)
+{
+    for (auto& band : bands)
+        band.setWavetableResolution(numEntries);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setWavetableInterpolation(EnvelopeCurve::Interpolation newInterpolation)
+{
+    for (auto& band : bands)
+        band.setWavetableInterpolation(newInterpolation);
+}
+
+template <typename SampleType>
+int MultibandCompressor<SampleType>::getLatencySamples() const
+{
+    return bands[0].getLatencySamples();
+}
+
+template <typename SampleType>
+float MultibandCompressor<SampleType>::getCurrentGainReduction() const
+{
+    float deepest = 0.0f;
+    for (int band = 0; band < numBands; ++band)
+        deepest = juce::jmax(deepest, bands[static_cast<size_t>(band)].getCurrentGainReduction());
+
+    return deepest;
+}
+
+template <typename SampleType>
+float MultibandCompressor<SampleType>::getCurrentInputLevel() const
+{
+    float loudest = bands[0].getCurrentInputLevel();
+    for (int band = 1; band < numBands; ++band)
+        loudest = juce::jmax(loudest, bands[static_cast<size_t>(band)].getCurrentInputLevel());
+
+    return loudest;
+}
+
+template <typename SampleType>
+double MultibandCompressor<SampleType>::getWavetableSwapsPerSecond()
+{
+    // A curve edit reaches every band that uses it, so the busiest band is
+    // the edit rate; a sum would count one edit once per band. Every band is
+    // queried so each one's rate window restarts
+    double swapsPerSecond = 0.0;
+    for (auto& band : bands)
+        swapsPerSecond = juce::jmax(swapsPerSecond, band.getWavetableSwapsPerSecond());
+
+    return swapsPerSecond;
+}
+
+template class MultibandCompressor<float>;
+template class MultibandCompressor<double>;
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include "Compressor.h"
+#include "CrossoverNetwork.h"
+
+// Multiband compressor: a Linkwitz-Riley crossover network feeding one
+// Compressor per band, with the bands summed back afterwards.
+//
+// Each band has its own threshold, attack/release times and wavetables
+// (through getBand()). Settings that change the band latencies or the static
+// curve shape are shared, so the bands stay time-aligned when summed.
+template <typename SampleType>
+class MultibandCompressor
+{
+public:
+    static constexpr int maxBands = CrossoverNetwork<SampleType>::maxBands;
+
+    MultibandCompressor() = default;
+    ~MultibandCompressor() = default;
+
+    void prepare(double sampleRate, int samplesPerBlock, int numChannels = 2, int numKeyChannels = 2);
+
+    // Each band is keyed by its own band signal
+    void process(juce::AudioBuffer<SampleType>& buffer);
+
+    // Every band is keyed by the whole detectorInput (e.g. an external sidechain),
+    // through its own key filter
+    void process(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>& detectorInput);
+
+    // 2 to maxBands; 1 runs a single band through the same path. Bands that
+    // become active start from a clean state
+    void setNumBands(int newNumBands);
+    int getNumBands() const;
+
+    // Crossover index sits between band index and band index + 1. The active
+    // crossovers are kept in 20 Hz - 20 kHz, rising by at least
+    // minCrossoverRatio, with the lower ones giving way to the higher ones
+    static constexpr float minCrossoverHz = 20.0f;
+    static constexpr float maxCrossoverHz = 20000.0f;
+    static constexpr float minCrossoverRatio = 1.2599210f;  // a third of an octave
+    void setCrossoverFrequency(int index, float frequencyHz);
+
+    // Per-band settings: threshold, attack/release times and wavetables
+    Compressor<SampleType>& getBand(int index);
+    const Compressor<SampleType>& getBand(int index) const;
+
+    // Shared settings, forwarded to every band
+    void setOversamplingFactor(int factorLog2);
+    void setLookahead(float newLookaheadMs);
+    void setKnee(float newKnee);
+    void setRatio(float newRatio);
+    void setDetectorMode(typename Compressor<SampleType>::DetectorMode newMode);
+    void setEnvelopeMode(typename Compressor<SampleType>::EnvelopeMode newMode);
+    void setKeyHighPass(float frequencyHz);
+    void setKeyLowPass(float frequencyHz);
+    void setInputGain(float newInputGain);
+    void setOutputGain(float newOutputGain);
+    void setLinkGroups(const int* groupOfChannel, int numChannels);
+    void setKeyChannelMap(const int* audioChannelOfKeyChannel, int numKeyChannels);
+    void setAttackWavetable(const std::array<float, 256>& wavetable);
+    void setReleaseWavetable(const std::array<float, 256>& wavetable);
+    void setWavetableResolution(int numEntries);
+    void setWavetableInterpolation(EnvelopeCurve::Interpolation newInterpolation);
+
+    // Same for every band, since the latency-affecting settings are shared
+    int getLatencySamples() const;
+
+    // Deepest gain reduction across the active bands, for visualization
+    float getCurrentGainReduction() const;
+
+    // Input level seen by the loudest active band, for visualization
+    float getCurrentInputLevel() const;
+
+    // Wavetable swaps per second picked up by the busiest band, since the previous call
+    double getWavetableSwapsPerSecond();
+
+private:
+    void processBlock(const juce::dsp::AudioBlock<SampleType>& block, const juce::dsp::AudioBlock<const SampleType>* detectorInput);
+    void updateCrossovers();
+
+    // Bands are split and compressed in short chunks, so all the band signals of
+    // a chunk stay in cache between the crossovers, the compressors and the sum
+    static constexpr int maxChunkSize = 256;
+
+    CrossoverNetwork<SampleType> crossover;
+    std::array<float, maxBands - 1> requestedCrossovers { 120.0f, 800.0f, 3000.0f, 8000.0f };
+    std::array<Compressor<SampleType>, maxBands> bands;
+    int numBands = 2;
+
+    // maxBands groups of numChannels channels, one chunk long
+    juce::AudioBuffer<SampleType> bandBuffer;
+    int numChannels = 0;
+    int chunkSize = 0;
+};
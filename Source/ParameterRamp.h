@@ -0,0 +1,76 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+//==============================================================================
+// A linearly smoothed parameter, rendered a chunk at a time.
+//
+// While the value is moving, advance() writes one value per sample into a
+// ramp buffer and isRamping() returns true. When it is settled nothing is
+// written and the constant is used, so the no-automation path costs one check.
+class ParameterRamp
+{
+public:
+    explicit ParameterRamp(float initialValue = 0.0f)
+    {
+        smoothed.setCurrentAndTargetValue(initialValue);
+    }
+
+    // Allocate the ramp buffer and jump to the current target
+    void prepare(double sampleRate, int maxBlockSize, double rampLengthSeconds)
+    {
+        smoothed.reset(sampleRate, rampLengthSeconds);
+        ramp.assign(static_cast<size_t>(juce::jmax(1, maxBlockSize)), smoothed.getTargetValue());
+        ramping = false;
+    }
+
+    // Change the rate the ramp advances at without reallocating; jumps to the target
+    void setSampleRate(double sampleRate, double rampLengthSeconds)
+    {
+        smoothed.reset(sampleRate, rampLengthSeconds);
+        ramping = false;
+    }
+
+    void setTargetValue(float newValue) { smoothed.setTargetValue(newValue); }
+    float getTargetValue() const { return smoothed.getTargetValue(); }
+
+    // Render the next numSamples values (at most the prepared block size)
+    void advance(int numSamples)
+    {
+        ramping = smoothed.isSmoothing();
+        if (! ramping)
+            return;
+
+        jassert(numSamples <= static_cast<int>(ramp.size()));
+        for (int i = 0; i < numSamples; ++i)
+            ramp[static_cast<size_t>(i)] = smoothed.getNextValue();
+    }
+
+    bool isRamping() const { return ramping; }
+    float getConstant() const { return smoothed.getCurrentValue(); }
+    const float* getRamp() const { return ramp.data(); }
+
+    // dest[i] *= value
+    void multiply(float* dest, int numSamples) const
+    {
+        if (ramping)
+            juce::FloatVectorOperations::multiply(dest, ramp.data(), numSamples);
+        else
+            juce::FloatVectorOperations::multiply(dest, getConstant(), numSamples);
+    }
+
+    // dest[i] -= value
+    void subtract(float* dest, int numSamples) const
+    {
+        if (ramping)
+            juce::FloatVectorOperations::subtract(dest, ramp.data(), numSamples);
+        else
+            juce::FloatVectorOperations::add(dest, -getConstant(), numSamples);
+    }
+
+private:
+    juce::LinearSmoothedValue<float> smoothed;
+    std::vector<float> ramp;
+    bool ramping = false;
+};
@@ -34,6 +34,7 @@ MyPluginAudioProcessorEditor::MyPluginAudioProcessorEditor (MyPluginAudioProcess
     setupSlider(outputGainSlider, outputGainLabel, "OUTPUT");
     setupSlider(thresholdSlider, thresholdLabel, "THRESHOLD");
     setupSlider(kneeSlider, kneeLabel, "KNEE");
+    setupSlider(ratioSlider, ratioLabel, "RATIO");
     setupSlider(attackTimeSlider, attackTimeLabel, "ATTACK TIME");
     setupSlider(releaseTimeSlider, releaseTimeLabel, "RELEASE TIME");
     
@@ -51,6 +52,8 @@ MyPluginAudioProcessorEditor::MyPluginAudioProcessorEditor (MyPluginAudioProcess
         parameters, MyPluginAudioProcessor::thresholdId, thresholdSlider);
     kneeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         parameters, MyPluginAudioProcessor::kneeId, kneeSlider);
+    ratioAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        parameters, MyPluginAudioProcessor::ratioId, ratioSlider);
     attackTimeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         parameters, MyPluginAudioProcessor::attackTimeId, attackTimeSlider);
     releaseTimeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
@@ -64,14 +67,14 @@ MyPluginAudioProcessorEditor::MyPluginAudioProcessorEditor (MyPluginAudioProcess
     attackWavetableEditor.setIsReleaseMode(false);
     attackWavetableEditor.setWavetable(processorRef.getCompressor().getAttackWavetable());
     attackWavetableEditor.setWavetableChangedCallback([this](const std::array<float, 256>& wavetable) {
-        processorRef.getCompressor().setAttackWavetable(wavetable);
+        processorRef.setAttackWavetable(wavetable);
     });
     
     addAndMakeVisible(releaseWavetableEditor);
     releaseWavetableEditor.setIsReleaseMode(true);
     releaseWavetableEditor.setWavetable(processorRef.getCompressor().getReleaseWavetable());
     releaseWavetableEditor.setWavetableChangedCallback([this](const std::array<float, 256>& wavetable) {
-        processorRef.getCompressor().setReleaseWavetable(wavetable);
+        processorRef.setReleaseWavetable(wavetable);
     });
     
     // Wavetable labels
@@ -86,6 +89,14 @@ MyPluginAudioProcessorEditor::MyPluginAudioProcessorEditor (MyPluginAudioProcess
     setupEditorLabel(attackEditorLabel, "ATTACK CURVE");
     setupEditorLabel(releaseEditorLabel, "RELEASE CURVE");
     
+    // DSP load readout; clicks fall through to the editor for the reset
+    addAndMakeVisible(dspLoadLabel);
+    dspLoadLabel.setJustificationType(juce::Justification::centred);
+    dspLoadLabel.setFont(juce::Font(13.0f));
+    dspLoadLabel.setColour(juce::Label::textColourId, sondyLookAndFeel.getThemeColors().dimText);
+    dspLoadLabel.setInterceptsMouseClicks(false, false);
+    updateDspLoadLabel();
+    
     // Set size of the editor
     setSize (1000, 650);
     
@@ -230,7 +241,7 @@ void MyPluginAudioProcessorEditor::resized()
     
     centerArea.removeFromTop(verticalGap * 2); // Extra space between meter and controls
     
-    // Four knobs in a grid (2x2) layout with spacing
+    // Knobs in two rows: two on top, three below
     const int knobWidth = centerWidth / 2;
     const int knobHeight = 110; // Increased height for knobs
     const int knobSpacing = 15;
@@ -245,20 +256,34 @@ void MyPluginAudioProcessorEditor::resized()
     
     centerArea.removeFromTop(verticalGap); // Space between rows
     
-    // Bottom row - Threshold and Knee
+    // Bottom row - Threshold, Ratio and Knee
+    const int smallKnobWidth = centerWidth / 3;
     auto bottomRowArea = centerArea.removeFromTop(knobHeight);
-    auto thresholdArea = bottomRowArea.removeFromLeft(knobWidth).reduced(knobSpacing);
+    auto thresholdArea = bottomRowArea.removeFromLeft(smallKnobWidth).reduced(knobSpacing / 2);
     thresholdSlider.setBounds(thresholdArea);
     
-    auto kneeArea = bottomRowArea.reduced(knobSpacing);
+    auto ratioArea = bottomRowArea.removeFromLeft(smallKnobWidth).reduced(knobSpacing / 2);
+    ratioSlider.setBounds(ratioArea);
+    
+    auto kneeArea = bottomRowArea.reduced(knobSpacing / 2);
     kneeSlider.setBounds(kneeArea);
+    
+    // DSP load readout along the bottom of the column
+    dspLoadLabel.setBounds(centerArea.removeFromBottom(24));
 }
 
 void MyPluginAudioProcessorEditor::timerCallback()
 {
     // Update the gain reduction meter
-    gainReductionMeter.setGainReduction(processorRef.getCompressor().getCurrentGainReduction());
-    gainReductionMeter.setInputLevel(processorRef.getCompressor().getCurrentInputLevel());
+    gainReductionMeter.setGainReduction(processorRef.getCurrentGainReduction());
+    gainReductionMeter.setInputLevel(processorRef.getCurrentInputLevel());
+    
+    // The load readout changes too fast to read at the full frame rate
+    if (--dspLoadUpdateCountdown <= 0)
+    {
+        updateDspLoadLabel();
+        dspLoadUpdateCountdown = 15;
+    }
     
     // Update background animation
     if (enableBackgroundAnimation)
@@ -269,4 +294,26 @@ void MyPluginAudioProcessorEditor::timerCallback()
             
         repaint();
     }
-} 
\ No newline at end of file
+} 
+
+void MyPluginAudioProcessorEditor::updateDspLoadLabel()
+{
+    const auto load = processorRef.getDspLoad();
+    auto toPercent = [](double fraction) { return juce::String(juce::roundToInt(fraction * 100.0)) + "%"; };
+    
+    juce::String text = load.numBlocks == 0 ? juce::String("DSP LOAD  --")
+                                            : "DSP LOAD  p50 " + toPercent(load.p50) + "   p99 " + toPercent(load.p99) + "   max " + toPercent(load.max);
+    
+    // Curve edits handed to the audio thread, to check they arrive while dragging
+    text << "   CURVE SWAPS " << juce::String(processorRef.getWavetableSwapsPerSecond(), 1) << "/s";
+    dspLoadLabel.setText(text, juce::dontSendNotification);
+}
+
+void MyPluginAudioProcessorEditor::mouseDoubleClick(const juce::MouseEvent& event)
+{
+    if (dspLoadLabel.getBounds().contains(event.getPosition()))
+    {
+        processorRef.resetDspLoad();
+        updateDspLoadLabel();
+    }
+}
@@ -29,6 +29,9 @@ public:
     void resized() override;
     
     void timerCallback() override;
+    
+    // Double-clicking the DSP load readout starts its statistics over
+    void mouseDoubleClick(const juce::MouseEvent& event) override;
 
 private:
     // Reference to our processor
@@ -48,6 +51,7 @@ private:
     juce::Slider outputGainSlider;
     juce::Slider thresholdSlider;
     juce::Slider kneeSlider;
+    juce::Slider ratioSlider;
     juce::Slider attackTimeSlider;
     juce::Slider releaseTimeSlider;
     
@@ -56,6 +60,7 @@ private:
     juce::Label outputGainLabel;
     juce::Label thresholdLabel;
     juce::Label kneeLabel;
+    juce::Label ratioLabel;
     juce::Label attackTimeLabel;
     juce::Label releaseTimeLabel;
     juce::Label attackEditorLabel;
@@ -68,11 +73,18 @@ private:
     // Gain reduction meter
     GainReductionMeter gainReductionMeter;
     
+    // processBlock time against the block's duration and the curve swap rate,
+    // refreshed a few times a second
+    juce::Label dspLoadLabel;
+    int dspLoadUpdateCountdown = 0;
+    void updateDspLoadLabel();
+    
     // Parameter attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> inputGainAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> outputGainAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> thresholdAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> kneeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> ratioAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> attackTimeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> releaseTimeAttachment;
     
@@ -6,39 +6,309 @@ const juce::String MyPluginAudioProcessor::inputGainId = "input_gain";
 const juce::String MyPluginAudioProcessor::outputGainId = "output_gain";
 const juce::String MyPluginAudioProcessor::thresholdId = "threshold";
 const juce::String MyPluginAudioProcessor::kneeId = "knee";
+const juce::String MyPluginAudioProcessor::ratioId = "ratio";
+const juce::String MyPluginAudioProcessor::oversamplingId = "oversampling";
+const juce::String MyPluginAudioProcessor::lookaheadId = "lookahead";
+const juce::String MyPluginAudioProcessor::detectorModeId = "detector_mode";
+const juce::String MyPluginAudioProcessor::curveInterpolationId = "curve_interpolation";
+const juce::String MyPluginAudioProcessor::sidechainEnabledId = "sidechain_enabled";
+const juce::String MyPluginAudioProcessor::keyHighPassId = "key_high_pass";
+const juce::String MyPluginAudioProcessor::keyLowPassId = "key_low_pass";
 const juce::String MyPluginAudioProcessor::attackTimeId = "attack_time";
 const juce::String MyPluginAudioProcessor::releaseTimeId = "release_time";
+const juce::String MyPluginAudioProcessor::numBandsId = "num_bands";
+const juce::String MyPluginAudioProcessor::channelLinkId = "channel_link";
+
+juce::String MyPluginAudioProcessor::crossoverFrequencyId(int index)
+{
+    return "crossover_" + juce::String(index + 1);
+}
+
+juce::String MyPluginAudioProcessor::bandThresholdId(int band)
+{
+    return "band" + juce::String(band + 1) + "_threshold";
+}
+
+juce::String MyPluginAudioProcessor::bandAttackTimeId(int band)
+{
+    return "band" + juce::String(band + 1) + "_attack_time";
+}
+
+juce::String MyPluginAudioProcessor::bandReleaseTimeId(int band)
+{
+    return "band" + juce::String(band + 1) + "_release_time";
+}
 
 MyPluginAudioProcessor::MyPluginAudioProcessor()
     : AudioProcessor (BusesProperties()
         .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
-      parameters(*this, nullptr, juce::Identifier("SondyComp"), 
-      {
-          std::make_unique<juce::AudioParameterFloat>(inputGainId, "Input Gain", -24.0f, 24.0f, 0.0f),
-          std::make_unique<juce::AudioParameterFloat>(outputGainId, "Output Gain", -24.0f, 24.0f, 0.0f),
-          std::make_unique<juce::AudioParameterFloat>(thresholdId, "Threshold", -60.0f, 0.0f, -12.0f),
-          std::make_unique<juce::AudioParameterFloat>(kneeId, "Knee", 0.0f, 24.0f, 6.0f),
-          std::make_unique<juce::AudioParameterFloat>(attackTimeId, "Attack Time", 0.01f, 1.0f, 0.1f),
-          std::make_unique<juce::AudioParameterFloat>(releaseTimeId, "Release Time", 0.01f, 3.0f, 0.3f)
-      })
+        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+        .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)),
+      parameters(*this, nullptr, juce::Identifier("SondyComp"), createParameterLayout())
 {
+    inputGainValue = parameters.getRawParameterValue(inputGainId);
+    outputGainValue = parameters.getRawParameterValue(outputGainId);
+    thresholdValue = parameters.getRawParameterValue(thresholdId);
+    kneeValue = parameters.getRawParameterValue(kneeId);
+    ratioValue = parameters.getRawParameterValue(ratioId);
+    attackTimeValue = parameters.getRawParameterValue(attackTimeId);
+    releaseTimeValue = parameters.getRawParameterValue(releaseTimeId);
+    oversamplingValue = parameters.getRawParameterValue(oversamplingId);
+    lookaheadValue = parameters.getRawParameterValue(lookaheadId);
+    detectorModeValue = parameters.getRawParameterValue(detectorModeId);
+    curveInterpolationValue = parameters.getRawParameterValue(curveInterpolationId);
+    sidechainEnabledValue = parameters.getRawParameterValue(sidechainEnabledId);
+    keyHighPassValue = parameters.getRawParameterValue(keyHighPassId);
+    keyLowPassValue = parameters.getRawParameterValue(keyLowPassId);
+    numBandsValue = parameters.getRawParameterValue(numBandsId);
+    channelLinkValue = parameters.getRawParameterValue(channelLinkId);
+    
+    for (int index = 0; index < maxBands - 1; ++index)
+        crossoverFrequencyValues[static_cast<size_t>(index)] = parameters.getRawParameterValue(crossoverFrequencyId(index));
+    
+    for (int band = 0; band < maxBands; ++band)
+    {
+        bandThresholdValues[static_cast<size_t>(band)] = parameters.getRawParameterValue(bandThresholdId(band));
+        bandAttackTimeValues[static_cast<size_t>(band)] = parameters.getRawParameterValue(bandAttackTimeId(band));
+        bandReleaseTimeValues[static_cast<size_t>(band)] = parameters.getRawParameterValue(bandReleaseTimeId(band));
+    }
+    
     // Initialize compressor with default parameter values
     updateCompressorSettings();
+    
+    // Picks up latency changes made on the audio thread
+    startTimerHz(20);
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout MyPluginAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>(inputGainId, "Input Gain", -24.0f, 24.0f, 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(outputGainId, "Output Gain", -24.0f, 24.0f, 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(thresholdId, "Threshold", -60.0f, 0.0f, -12.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(kneeId, "Knee", 0.0f, 24.0f, 6.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(ratioId, "Ratio",
+        juce::NormalisableRange<float>(1.0f, maxRatio, 0.1f, 0.5f), 4.0f,
+        juce::AudioParameterFloatAttributes()
+            .withStringFromValueFunction([](float value, int) {
+                return value >= maxRatio ? juce::String("inf:1") : juce::String(value, 1) + ":1";
+            })
+            .withValueFromStringFunction([](const juce::String& text) {
+                return text.trim().startsWithIgnoreCase("inf") ? maxRatio : text.getFloatValue();
+            })));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(attackTimeId, "Attack Time", 0.01f, 1.0f, 0.1f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(releaseTimeId, "Release Time", 0.01f, 3.0f, 0.3f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(oversamplingId, "Oversampling",
+        juce::StringArray { "Off", "2x", "4x", "8x" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(lookaheadId, "Lookahead",
+        juce::NormalisableRange<float>(0.0f, Compressor<float>::maxLookaheadMs, 0.1f), 0.0f,
+        juce::AudioParameterFloatAttributes().withLabel("ms")));
+    // The eco envelope only runs with the RMS detector, so it is offered as a
+    // detector choice of its own rather than a switch the others would ignore
+    layout.add(std::make_unique<juce::AudioParameterChoice>(detectorModeId, "Detector",
+        juce::StringArray { "Peak", "RMS", "Peak/RMS", "RMS Eco" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(curveInterpolationId, "Curve Interpolation",
+        juce::StringArray { "Linear", "Cubic" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(channelLinkId, "Channel Link",
+        juce::StringArray { "Linked", "LFE Independent", "By Position", "Unlinked" }, 0));
+    layout.add(std::make_unique<juce::AudioParameterBool>(sidechainEnabledId, "External Sidechain", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(keyHighPassId, "Key High-Pass",
+        juce::NormalisableRange<float>(KeyFilter<float>::minHighPassHz, 2000.0f, 1.0f, 0.3f), KeyFilter<float>::minHighPassHz,
+        juce::AudioParameterFloatAttributes().withLabel("Hz")));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(keyLowPassId, "Key Low-Pass",
+        juce::NormalisableRange<float>(1000.0f, KeyFilter<float>::maxLowPassHz, 1.0f, 0.3f), KeyFilter<float>::maxLowPassHz,
+        juce::AudioParameterFloatAttributes().withLabel("Hz")));
+    
+    // Multiband: band count, crossovers, and per-band threshold and times
+    layout.add(std::make_unique<juce::AudioParameterInt>(numBandsId, "Bands", 1, maxBands, 1));
+    
+    for (int index = 0; index < maxBands - 1; ++index)
+        layout.add(std::make_unique<juce::AudioParameterFloat>(crossoverFrequencyId(index), "Crossover " + juce::String(index + 1),
+            juce::NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), defaultCrossoverFrequencies[static_cast<size_t>(index)],
+            juce::AudioParameterFloatAttributes().withLabel("Hz")));
+    
+    for (int band = 0; band < maxBands; ++band)
+    {
+        const auto bandName = "Band " + juce::String(band + 1) + " ";
+        layout.add(std::make_unique<juce::AudioParameterFloat>(bandThresholdId(band), bandName + "Threshold", -60.0f, 0.0f, -12.0f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(bandAttackTimeId(band), bandName + "Attack Time", 0.01f, 1.0f, 0.1f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(bandReleaseTimeId(band), bandName + "Release Time", 0.01f, 3.0f, 0.3f));
+    }
+    
+    return layout;
 }
 
 MyPluginAudioProcessor::~MyPluginAudioProcessor()
 {
+    stopTimer();
 }
 
 void MyPluginAudioProcessor::updateCompressorSettings()
 {
-    compressor.setInputGain(parameters.getRawParameterValue(inputGainId)->load());
-    compressor.setOutputGain(parameters.getRawParameterValue(outputGainId)->load());
-    compressor.setThreshold(parameters.getRawParameterValue(thresholdId)->load());
-    compressor.setKnee(parameters.getRawParameterValue(kneeId)->load());
-    compressor.setAttackTime(parameters.getRawParameterValue(attackTimeId)->load());
-    compressor.setReleaseTime(parameters.getRawParameterValue(releaseTimeId)->load());
+    updateEngineSettings(floatEngines);
+    updateEngineSettings(doubleEngines);
+}
+
+template <typename SampleType>
+void MyPluginAudioProcessor::updateEngineSettings(Engines<SampleType>& engines)
+{
+    using DetectorMode = typename Compressor<SampleType>::DetectorMode;
+    using EnvelopeMode = typename Compressor<SampleType>::EnvelopeMode;
+    auto& compressor = engines.compressor;
+    auto& multibandCompressor = engines.multibandCompressor;
+    
+    const auto detectorChoice = static_cast<int>(detectorModeValue->load(std::memory_order_relaxed));
+    const bool rmsEco = detectorChoice == rmsEcoDetectorChoice;
+    const auto detectorMode = rmsEco ? DetectorMode::rms : static_cast<DetectorMode>(detectorChoice);
+    const auto envelopeMode = rmsEco ? EnvelopeMode::eco : EnvelopeMode::perSample;
+    
+    compressor.setInputGain(inputGainValue->load(std::memory_order_relaxed));
+    compressor.setOutputGain(outputGainValue->load(std::memory_order_relaxed));
+    compressor.setThreshold(thresholdValue->load(std::memory_order_relaxed));
+    compressor.setKnee(kneeValue->load(std::memory_order_relaxed));
+    compressor.setRatio(ratioParameterToRatio(ratioValue->load(std::memory_order_relaxed)));
+    compressor.setAttackTime(attackTimeValue->load(std::memory_order_relaxed));
+    compressor.setReleaseTime(releaseTimeValue->load(std::memory_order_relaxed));
+    compressor.setOversamplingFactor(static_cast<int>(oversamplingValue->load(std::memory_order_relaxed)));
+    compressor.setLookahead(lookaheadValue->load(std::memory_order_relaxed));
+    compressor.setDetectorMode(detectorMode);
+    compressor.setEnvelopeMode(envelopeMode);
+    compressor.setWavetableInterpolation(static_cast<EnvelopeCurve::Interpolation>(static_cast<int>(curveInterpolationValue->load(std::memory_order_relaxed))));
+    compressor.setKeyHighPass(keyHighPassValue->load(std::memory_order_relaxed));
+    compressor.setKeyLowPass(keyLowPassValue->load(std::memory_order_relaxed));
+    
+    // Multiband shares the global settings except threshold and times, which are per band
+    multibandCompressor.setNumBands(juce::roundToInt(numBandsValue->load(std::memory_order_relaxed)));
+    multibandCompressor.setInputGain(inputGainValue->load(std::memory_order_relaxed));
+    multibandCompressor.setOutputGain(outputGainValue->load(std::memory_order_relaxed));
+    multibandCompressor.setKnee(kneeValue->load(std::memory_order_relaxed));
+    multibandCompressor.setRatio(ratioParameterToRatio(ratioValue->load(std::memory_order_relaxed)));
+    multibandCompressor.setOversamplingFactor(static_cast<int>(oversamplingValue->load(std::memory_order_relaxed)));
+    multibandCompressor.setLookahead(lookaheadValue->load(std::memory_order_relaxed));
+    multibandCompressor.setDetectorMode(detectorMode);
+    multibandCompressor.setEnvelopeMode(envelopeMode);
+    multibandCompressor.setWavetableInterpolation(static_cast<EnvelopeCurve::Interpolation>(static_cast<int>(curveInterpolationValue->load(std::memory_order_relaxed))));
+    multibandCompressor.setKeyHighPass(keyHighPassValue->load(std::memory_order_relaxed));
+    multibandCompressor.setKeyLowPass(keyLowPassValue->load(std::memory_order_relaxed));
+    
+    for (int index = 0; index < maxBands - 1; ++index)
+        multibandCompressor.setCrossoverFrequency(index, crossoverFrequencyValues[static_cast<size_t>(index)]->load(std::memory_order_relaxed));
+    
+    for (int band = 0; band < maxBands; ++band)
+    {
+        auto& bandCompressor = multibandCompressor.getBand(band);
+        bandCompressor.setThreshold(bandThresholdValues[static_cast<size_t>(band)]->load(std::memory_order_relaxed));
+        bandCompressor.setAttackTime(bandAttackTimeValues[static_cast<size_t>(band)]->load(std::memory_order_relaxed));
+        bandCompressor.setReleaseTime(bandReleaseTimeValues[static_cast<size_t>(band)]->load(std::memory_order_relaxed));
+    }
+}
+
+void MyPluginAudioProcessor::updateLinkGroups()
+{
+    const int linkMode = static_cast<int>(channelLinkValue->load(std::memory_order_relaxed));
+    if (linkMode == activeLinkMode || ! juce::isPositiveAndBelow(linkMode, ChannelLinking::numModes))
+        return;
+    
+    // Group maps were built for the current layout in prepareToPlay()
+    const auto& groups = linkGroupMaps[static_cast<size_t>(linkMode)];
+    if (groups.empty())
+        return;
+    
+    activeLinkMode = linkMode;
+    const auto numChannels = static_cast<int>(groups.size());
+    floatEngines.compressor.setLinkGroups(groups.data(), numChannels);
+    floatEngines.multibandCompressor.setLinkGroups(groups.data(), numChannels);
+    doubleEngines.compressor.setLinkGroups(groups.data(), numChannels);
+    doubleEngines.multibandCompressor.setLinkGroups(groups.data(), numChannels);
+}
+
+bool MyPluginAudioProcessor::isMultibandActive() const
+{
+    return juce::roundToInt(numBandsValue->load(std::memory_order_relaxed)) > 1;
+}
+
+template <typename SampleType>
+float MyPluginAudioProcessor::getCurrentGainReduction(const Engines<SampleType>& engines) const
+{
+    return isMultibandActive() ? engines.multibandCompressor.getCurrentGainReduction()
+                               : engines.compressor.getCurrentGainReduction();
+}
+
+float MyPluginAudioProcessor::getCurrentGainReduction() const
+{
+    return isUsingDoublePrecision() ? getCurrentGainReduction(doubleEngines)
+                                    : getCurrentGainReduction(floatEngines);
+}
+
+template <typename SampleType>
+float MyPluginAudioProcessor::getCurrentInputLevel(const Engines<SampleType>& engines) const
+{
+    return isMultibandActive() ? engines.multibandCompressor.getCurrentInputLevel()
+                               : engines.compressor.getCurrentInputLevel();
+}
+
+float MyPluginAudioProcessor::getCurrentInputLevel() const
+{
+    return isUsingDoublePrecision() ? getCurrentInputLevel(doubleEngines)
+                                    : getCurrentInputLevel(floatEngines);
+}
+
+template <typename SampleType>
+double MyPluginAudioProcessor::getWavetableSwapsPerSecond(Engines<SampleType>& engines)
+{
+    return isMultibandActive() ? engines.multibandCompressor.getWavetableSwapsPerSecond()
+                               : engines.compressor.getWavetableSwapsPerSecond();
+}
+
+double MyPluginAudioProcessor::getWavetableSwapsPerSecond()
+{
+    return isUsingDoublePrecision() ? getWavetableSwapsPerSecond(doubleEngines)
+                                    : getWavetableSwapsPerSecond(floatEngines);
+}
+
+void MyPluginAudioProcessor::setAttackWavetable(const std::array<float, 256>& wavetable)
+{
+    floatEngines.compressor.setAttackWavetable(wavetable);
+    floatEngines.multibandCompressor.setAttackWavetable(wavetable);
+    doubleEngines.compressor.setAttackWavetable(wavetable);
+    doubleEngines.multibandCompressor.setAttackWavetable(wavetable);
+}
+
+void MyPluginAudioProcessor::setReleaseWavetable(const std::array<float, 256>& wavetable)
+{
+    floatEngines.compressor.setReleaseWavetable(wavetable);
+    floatEngines.multibandCompressor.setReleaseWavetable(wavetable);
+    doubleEngines.compressor.setReleaseWavetable(wavetable);
+    doubleEngines.multibandCompressor.setReleaseWavetable(wavetable);
+}
+
+void MyPluginAudioProcessor::setWavetableResolution(int numEntries)
+{
+    floatEngines.compressor.setWavetableResolution(numEntries);
+    floatEngines.multibandCompressor.setWavetableResolution(numEntries);
+    doubleEngines.compressor.setWavetableResolution(numEntries);
+    doubleEngines.multibandCompressor.setWavetableResolution(numEntries);
+}
+
+template <typename SampleType>
+void MyPluginAudioProcessor::publishLatency(const Engines<SampleType>& engines)
+{
+    publishedLatency.store(isMultibandActive() ? engines.multibandCompressor.getLatencySamples()
+                                               : engines.compressor.getLatencySamples(),
+                           std::memory_order_relaxed);
+}
+
+void MyPluginAudioProcessor::timerCallback()
+{
+    const int latency = publishedLatency.load(std::memory_order_relaxed);
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+}
+
+float MyPluginAudioProcessor::ratioParameterToRatio(float parameterValue)
+{
+    return parameterValue >= maxRatio ? std::numeric_limits<float>::infinity() : parameterValue;
 }
 
 const juce::String MyPluginAudioProcessor::getName() const
@@ -46,6 +316,11 @@ const juce::String MyPluginAudioProcessor::getName() const
     return JucePlugin_Name;
 }
 
+bool MyPluginAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 bool MyPluginAudioProcessor::acceptsMidi() const
 {
     return true;
@@ -91,8 +366,48 @@ void MyPluginAudioProcessor::changeProgramName (int index, const juce::String& n
 
 void MyPluginAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Initialize the compressor with the sample rate
-    compressor.prepare(sampleRate, samplesPerBlock);
+    // Initialize the compressor with the sample rate. Only the engines for the
+    // host's processing precision are allocated
+    updateCompressorSettings();
+    const auto numKeyChannels = juce::jmax(getMainBusNumInputChannels(), getChannelCountOfBus(true, 1));
+    if (isUsingDoublePrecision())
+        prepareEngines(doubleEngines, sampleRate, samplesPerBlock, numKeyChannels);
+    else
+        prepareEngines(floatEngines, sampleRate, samplesPerBlock, numKeyChannels);
+    
+    // Link groups depend on the bus layout, so every mode's map is built here
+    // rather than on the audio thread
+    const auto mainLayout = getChannelLayoutOfBus(false, 0);
+    for (int mode = 0; mode < ChannelLinking::numModes; ++mode)
+        linkGroupMaps[static_cast<size_t>(mode)] = ChannelLinking::makeGroups(mainLayout, static_cast<ChannelLinking::Mode>(mode));
+    
+    activeLinkMode = -1;
+    updateLinkGroups();
+    
+    // An external key drives the link groups of the channels it stands for
+    const auto keyChannelMap = ChannelLinking::makeKeyChannelMap(getChannelLayoutOfBus(true, 1), mainLayout);
+    const auto numMappedKeyChannels = static_cast<int>(keyChannelMap.size());
+    floatEngines.compressor.setKeyChannelMap(keyChannelMap.data(), numMappedKeyChannels);
+    floatEngines.multibandCompressor.setKeyChannelMap(keyChannelMap.data(), numMappedKeyChannels);
+    doubleEngines.compressor.setKeyChannelMap(keyChannelMap.data(), numMappedKeyChannels);
+    doubleEngines.multibandCompressor.setKeyChannelMap(keyChannelMap.data(), numMappedKeyChannels);
+    
+    // prepareToPlay() runs on the message thread, so the host hears about the
+    // latency straight away
+    if (isUsingDoublePrecision())
+        publishLatency(doubleEngines);
+    else
+        publishLatency(floatEngines);
+    
+    setLatencySamples(publishedLatency.load(std::memory_order_relaxed));
+    dspLoadMeter.prepare(sampleRate);
+}
+
+template <typename SampleType>
+void MyPluginAudioProcessor::prepareEngines(Engines<SampleType>& engines, double sampleRate, int samplesPerBlock, int numKeyChannels)
+{
+    engines.compressor.prepare(sampleRate, samplesPerBlock, getMainBusNumOutputChannels(), numKeyChannels);
+    engines.multibandCompressor.prepare(sampleRate, samplesPerBlock, getMainBusNumOutputChannels(), numKeyChannels);
 }
 
 void MyPluginAudioProcessor::releaseResources()
@@ -102,17 +417,50 @@ void MyPluginAudioProcessor::releaseResources()
 
 bool MyPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    const auto mainOutput = layouts.getMainOutputChannelSet();
+    const juce::AudioChannelSet supportedLayouts[] = {
+        juce::AudioChannelSet::mono(),
+        juce::AudioChannelSet::stereo(),
+        juce::AudioChannelSet::create5point1(),
+        juce::AudioChannelSet::create7point1(),
+        juce::AudioChannelSet::create7point1point4(),
+        juce::AudioChannelSet::ambisonic(1),
+        juce::AudioChannelSet::ambisonic(3)
+    };
+    
+    if (std::find(std::begin(supportedLayouts), std::end(supportedLayouts), mainOutput) == std::end(supportedLayouts))
+        return false;
+
+    if (mainOutput != layouts.getMainInputChannelSet())
         return false;
 
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    // The sidechain is optional: disabled, mono, stereo or the main layout
+    const auto sidechain = layouts.getChannelSet(true, 1);
+    if (! sidechain.isDisabled()
+        && sidechain != juce::AudioChannelSet::mono()
+        && sidechain != juce::AudioChannelSet::stereo()
+        && sidechain != mainOutput)
         return false;
 
     return true;
 }
 
-void MyPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void MyPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    const RealtimeChecks::ScopedAudioCallback audioCallback;
+    const DspLoadMeter::ScopedTimer loadTimer(dspLoadMeter, buffer.getNumSamples());
+    processSamples(buffer, floatEngines);
+}
+
+void MyPluginAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    const RealtimeChecks::ScopedAudioCallback audioCallback;
+    const DspLoadMeter::ScopedTimer loadTimer(dspLoadMeter, buffer.getNumSamples());
+    processSamples(buffer, doubleEngines);
+}
+
+template <typename SampleType>
+void MyPluginAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer, Engines<SampleType>& engines)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -123,10 +471,33 @@ void MyPluginAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
         buffer.clear (i, 0, buffer.getNumSamples());
 
     // Update parameters before processing
-    updateCompressorSettings();
+    updateEngineSettings(engines);
+    updateLinkGroups();
+    
+    // Process the main bus through the compressor, keyed by the sidechain when it
+    // is enabled and connected. Bus buffers refer to the host's data; nothing is copied
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
+    const bool useSidechain = sidechainEnabledValue->load(std::memory_order_relaxed) >= 0.5f
+                              && getChannelCountOfBus(true, 1) > 0;
+    
+    if (isMultibandActive())
+    {
+        if (useSidechain)
+            engines.multibandCompressor.process(mainBuffer, getBusBuffer(buffer, true, 1));
+        else
+            engines.multibandCompressor.process(mainBuffer);
+    }
+    else if (useSidechain)
+    {
+        engines.compressor.process(mainBuffer, getBusBuffer(buffer, true, 1));
+    }
+    else
+    {
+        engines.compressor.process(mainBuffer);
+    }
     
-    // Process the audio through the compressor
-    compressor.process(buffer);
+    // Oversampling and lookahead changes take effect inside process(), so latency is checked after it
+    publishLatency(engines);
 }
 
 bool MyPluginAudioProcessor::hasEditor() const
@@ -152,11 +523,10 @@ void MyPluginAudioProcessor::setStateInformation (const void* data, int sizeInBy
     // Restore parameters
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     
+    // Only the parameter values change here; processSamples() hands them to
+    // the engines at the start of the next block, on the audio thread
     if (xmlState != nullptr && xmlState->hasTagName(parameters.state.getType()))
-    {
         parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
-        updateCompressorSettings();
-    }
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -7,14 +7,19 @@
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_core/juce_core.h>
 #include <juce_data_structures/juce_data_structures.h>
+#include <juce_dsp/juce_dsp.h>
 #include <juce_events/juce_events.h>
 #include <juce_graphics/juce_graphics.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
 
 #include "Compressor.h"
+#include "MultibandCompressor.h"
+#include "ChannelLinking.h"
+#include "RealtimeChecks.h"
+#include "DspLoadMeter.h"
 
-class MyPluginAudioProcessor : public juce::AudioProcessor
+class MyPluginAudioProcessor : public juce::AudioProcessor, private juce::Timer
 {
 public:
     MyPluginAudioProcessor();
@@ -26,6 +31,8 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -47,7 +54,27 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     
     // Get the compressor for the editor
-    Compressor& getCompressor() { return compressor; }
+    Compressor<float>& getCompressor() { return floatEngines.compressor; }
+    
+    // Meter readings from whichever engine is running (single band or multiband)
+    float getCurrentGainReduction() const;
+    float getCurrentInputLevel() const;
+    
+    // Time spent in processBlock as a fraction of each block's duration, since
+    // prepareToPlay() or the last reset. Safe to call from any thread
+    DspLoadMeter::Statistics getDspLoad() const { return dspLoadMeter.getStatistics(); }
+    void resetDspLoad() { dspLoadMeter.reset(); }
+    
+    // Edited curves picked up by the running engine per second, since the
+    // previous call (message thread)
+    double getWavetableSwapsPerSecond();
+    
+    // Wavetables edited in the UI apply to the single-band compressor and every band
+    void setAttackWavetable(const std::array<float, 256>& wavetable);
+    void setReleaseWavetable(const std::array<float, 256>& wavetable);
+    
+    // Table size the curves are rendered at, EnvelopeCurve::minResolution to maxResolution
+    void setWavetableResolution(int numEntries);
     
     // Parameter Value Tree
     juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
@@ -57,18 +84,121 @@ public:
     static const juce::String outputGainId;
     static const juce::String thresholdId;
     static const juce::String kneeId;
+    static const juce::String ratioId;
+    static const juce::String oversamplingId;
+    static const juce::String lookaheadId;
+    static const juce::String detectorModeId;
+    static const juce::String curveInterpolationId;
+    static const juce::String sidechainEnabledId;
+    static const juce::String keyHighPassId;
+    static const juce::String keyLowPassId;
     static const juce::String attackTimeId;
     static const juce::String releaseTimeId;
+    static const juce::String numBandsId;
+    static const juce::String channelLinkId;
+    
+    // Multiband IDs; crossover index sits between band index and band index + 1
+    static juce::String crossoverFrequencyId(int index);
+    static juce::String bandThresholdId(int band);
+    static juce::String bandAttackTimeId(int band);
+    static juce::String bandReleaseTimeId(int band);
 
 private:
-    // The actual compressor that processes the audio
-    Compressor compressor;
+    // The compressors that process the audio, one set per sample type. The
+    // multiband engine is used instead when more than one band is selected
+    template <typename SampleType>
+    struct Engines
+    {
+        Compressor<SampleType> compressor;
+        MultibandCompressor<SampleType> multibandCompressor;
+    };
+    
+    Engines<float> floatEngines;
+    Engines<double> doubleEngines;
+    
+    static constexpr int maxBands = MultibandCompressor<float>::maxBands;
+    
+    // Detector choice after the three detector modes: RMS with the eco envelope
+    static constexpr int rmsEcoDetectorChoice = 3;
     
     // Parameter handling
     juce::AudioProcessorValueTreeState parameters;
     
-    // Parameter change handlers
+    // Raw parameter values, looked up once instead of by ID on every block
+    std::atomic<float>* inputGainValue = nullptr;
+    std::atomic<float>* outputGainValue = nullptr;
+    std::atomic<float>* thresholdValue = nullptr;
+    std::atomic<float>* kneeValue = nullptr;
+    std::atomic<float>* ratioValue = nullptr;
+    std::atomic<float>* attackTimeValue = nullptr;
+    std::atomic<float>* releaseTimeValue = nullptr;
+    std::atomic<float>* oversamplingValue = nullptr;
+    std::atomic<float>* lookaheadValue = nullptr;
+    std::atomic<float>* detectorModeValue = nullptr;
+    std::atomic<float>* curveInterpolationValue = nullptr;
+    std::atomic<float>* sidechainEnabledValue = nullptr;
+    std::atomic<float>* keyHighPassValue = nullptr;
+    std::atomic<float>* keyLowPassValue = nullptr;
+    std::atomic<float>* numBandsValue = nullptr;
+    std::atomic<float>* channelLinkValue = nullptr;
+    std::array<std::atomic<float>*, maxBands - 1> crossoverFrequencyValues {};
+    std::array<std::atomic<float>*, maxBands> bandThresholdValues {};
+    std::array<std::atomic<float>*, maxBands> bandAttackTimeValues {};
+    std::array<std::atomic<float>*, maxBands> bandReleaseTimeValues {};
+    
+    // Parameter change handlers. The compressor setters ignore unchanged values
+    // and smooth the ones that move
     void updateCompressorSettings();
     
+    template <typename SampleType>
+    void updateEngineSettings(Engines<SampleType>& engines);
+    
+    template <typename SampleType>
+    void prepareEngines(Engines<SampleType>& engines, double sampleRate, int samplesPerBlock, int numKeyChannels);
+    
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, Engines<SampleType>& engines);
+    
+    template <typename SampleType>
+    float getCurrentGainReduction(const Engines<SampleType>& engines) const;
+    
+    template <typename SampleType>
+    float getCurrentInputLevel(const Engines<SampleType>& engines) const;
+    
+    template <typename SampleType>
+    double getWavetableSwapsPerSecond(Engines<SampleType>& engines);
+    
+    bool isMultibandActive() const;
+    
+    // Hand the selected link mode's groups to the compressors when it changes.
+    // Only called from prepareToPlay() and the audio thread, which own the maps
+    void updateLinkGroups();
+    
+    // Link groups for the current main bus layout, one map per ChannelLinking::Mode
+    std::array<std::vector<int>, ChannelLinking::numModes> linkGroupMaps;
+    int activeLinkMode = -1;
+    
+    // The audio thread publishes the active engine's latency here, and the
+    // timer reports it to the host from the message thread, since
+    // setLatencySamples() notifies the host and isn't realtime safe
+    template <typename SampleType>
+    void publishLatency(const Engines<SampleType>& engines);
+    std::atomic<int> publishedLatency { 0 };
+    void timerCallback() override;
+    
+    // The top of the ratio range stands for infinity:1 (limiting)
+    static constexpr float maxRatio = 20.0f;
+    static float ratioParameterToRatio(float parameterValue);
+    
+    static constexpr std::array<float, maxBands - 1> defaultCrossoverFrequencies { 120.0f, 800.0f, 3000.0f, 8000.0f };
+    
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    
+    DspLoadMeter dspLoadMeter;
+    
+    // Logs what processBlock() does that isn't realtime safe, in builds with
+    // SONDYCOMP_RT_CHECKS
+    RealtimeChecks::Reporter realtimeReporter;
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MyPluginAudioProcessor)
 };
\ No newline at end of file
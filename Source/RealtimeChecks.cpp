@@ -0,0 +1,430 @@
+#include "RealtimeChecks.h"
+
+const char* RealtimeChecks::getName(Kind kind)
+{
+    switch (kind)
+    {
+        case Kind::allocation:   return "allocation";
+        case Kind::deallocation: return "deallocation";
+        case Kind::mutexLock:    return "mutex lock";
+        case Kind::blockingCall: return "blocking call";
+    }
+
+    return "";
+}
+
+#if SONDYCOMP_RT_CHECKS
+
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <execinfo.h>
+#endif
+
+#if JUCE_LINUX
+ #include <fcntl.h>
+ #include <poll.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <sys/select.h>
+ #include <unistd.h>
+
+ // The hooks run inside malloc; initial-exec TLS is reached without the
+ // lazy allocation a dlopen()ed library's TLS would otherwise need
+ #define SONDYCOMP_RT_TLS __attribute__((tls_model("initial-exec")))
+
+ // The allocator underneath the wrapped malloc family
+ extern "C" void* __real_malloc(size_t);
+ extern "C" void __real_free(void*);
+ extern "C" int __real_posix_memalign(void**, size_t, size_t);
+ #define SONDYCOMP_RT_RAW(function) __real_##function
+#else
+ #define SONDYCOMP_RT_TLS
+ #define SONDYCOMP_RT_RAW(function) function
+#endif
+
+namespace
+{
+    using RealtimeChecks::Kind;
+
+    constexpr int maxFrames = 32;
+    constexpr juce::uint32 queueSize = 128;
+
+    struct Violation
+    {
+        Kind kind = Kind::allocation;
+        const char* function = nullptr;
+        int numFrames = 0;
+        void* frames[maxFrames] {};
+    };
+
+    struct Slot
+    {
+        std::atomic<bool> ready { false };
+        Violation violation;
+    };
+
+    // Violations waiting for the report thread. Everything the hooks touch is
+    // constant-initialised, so no static initialiser ever runs inside one
+    std::array<Slot, queueSize> slots;
+    std::atomic<juce::uint32> writeIndex { 0 };
+    std::atomic<juce::uint32> readIndex { 0 };
+    std::atomic<int> numViolations { 0 };
+    std::atomic<int> numDropped { 0 };
+    std::atomic<bool> abortOnViolation { false };
+
+    SONDYCOMP_RT_TLS thread_local int callbackDepth = 0;
+    SONDYCOMP_RT_TLS thread_local bool isRecording = false;
+
+    int captureStack(void** frames)
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        return backtrace(frames, maxFrames);
+       #else
+        juce::ignoreUnused(frames);
+        return 0;
+       #endif
+    }
+
+    // Called from every hook. Does nothing outside the audio callback, and
+    // ignores whatever capturing the stack itself calls
+    void record(Kind kind, const char* function) noexcept
+    {
+        if (callbackDepth == 0 || isRecording)
+            return;
+
+        isRecording = true;
+        numViolations.fetch_add(1, std::memory_order_relaxed);
+
+        if (abortOnViolation.load(std::memory_order_relaxed))
+        {
+            void* frames[maxFrames];
+            const auto numFrames = captureStack(frames);
+            std::fprintf(stderr, "Realtime check failed: %s (%s) in the audio callback\n", RealtimeChecks::getName(kind), function);
+           #if JUCE_LINUX || JUCE_MAC
+            backtrace_symbols_fd(frames, numFrames, 2);
+           #else
+            juce::ignoreUnused(numFrames);
+           #endif
+            std::abort();
+        }
+
+        // Claim a slot; audio threads of several instances may race here
+        auto index = writeIndex.load(std::memory_order_relaxed);
+        do
+        {
+            if (index - readIndex.load(std::memory_order_acquire) >= queueSize)
+            {
+                numDropped.fetch_add(1, std::memory_order_relaxed);
+                isRecording = false;
+                return;
+            }
+        }
+        while (! writeIndex.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        auto& slot = slots[index % queueSize];
+        slot.violation.kind = kind;
+        slot.violation.function = function;
+        slot.violation.numFrames = captureStack(slot.violation.frames);
+        slot.ready.store(true, std::memory_order_release);
+
+        isRecording = false;
+    }
+
+    bool pop(Violation& violation)
+    {
+        const auto index = readIndex.load(std::memory_order_relaxed);
+        auto& slot = slots[index % queueSize];
+
+        if (! slot.ready.load(std::memory_order_acquire))
+            return false;
+
+        violation = slot.violation;
+        slot.ready.store(false, std::memory_order_relaxed);
+        readIndex.store(index + 1, std::memory_order_release);
+        return true;
+    }
+
+    //==============================================================================
+    // Logs each call site's first violation with its stack, and counts the rest
+    class ReportThread : public juce::Thread
+    {
+    public:
+        ReportThread() : juce::Thread("Realtime check reporter") {}
+
+        ~ReportThread() override
+        {
+            stopThread(1000);
+            report();
+
+            juce::Logger::writeToLog(numReported == 0 ? juce::String("Realtime checks: no violations")
+                                                       : "Realtime checks: " + juce::String(numReported) + " violations at "
+                                                         + juce::String(static_cast<int>(callSites.size())) + " call sites");
+        }
+
+        void run() override
+        {
+            while (! threadShouldExit())
+            {
+                wait(100);
+                report();
+            }
+        }
+
+    private:
+        std::unordered_map<juce::uint64, int> callSites;
+        int numReported = 0;
+        int lastNumDropped = 0;
+
+        void report()
+        {
+            Violation violation;
+            while (pop(violation))
+            {
+                ++numReported;
+
+                if (++callSites[getCallSite(violation)] == 1)
+                    juce::Logger::writeToLog("Realtime check failed: " + juce::String(RealtimeChecks::getName(violation.kind))
+                                             + " (" + violation.function + ") in the audio callback\n" + describeStack(violation));
+            }
+
+            if (const auto dropped = numDropped.load(std::memory_order_relaxed); dropped != lastNumDropped)
+            {
+                juce::Logger::writeToLog("Realtime checks: " + juce::String(dropped - lastNumDropped) + " violations dropped, the queue was full");
+                numReported += dropped - lastNumDropped;
+                lastNumDropped = dropped;
+            }
+        }
+
+        static juce::uint64 getCallSite(const Violation& violation)
+        {
+            juce::uint64 hash = 0xcbf29ce484222325ull ^ static_cast<juce::uint64>(violation.kind);
+
+            for (int frame = 0; frame < violation.numFrames; ++frame)
+                hash = (hash ^ static_cast<juce::uint64>(reinterpret_cast<juce::pointer_sized_uint>(violation.frames[frame]))) * 0x100000001b3ull;
+
+            return hash;
+        }
+
+        static juce::String describeStack(const Violation& violation)
+        {
+           #if JUCE_LINUX || JUCE_MAC
+            juce::String description;
+
+            if (auto* symbols = backtrace_symbols(violation.frames, violation.numFrames))
+            {
+                for (int frame = 0; frame < violation.numFrames; ++frame)
+                    description << "    " << symbols[frame] << "\n";
+
+                std::free(symbols);
+            }
+
+            return description;
+           #else
+            juce::ignoreUnused(violation);
+            return "    (no stack trace on this platform)\n";
+           #endif
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReportThread)
+    };
+
+    std::mutex reporterLock;
+    int numReporters = 0;
+    std::unique_ptr<ReportThread> reportThread;
+
+    //==============================================================================
+    void* allocate(std::size_t size, std::size_t alignment) noexcept
+    {
+        record(Kind::allocation, "operator new");
+        size = juce::jmax(size, static_cast<std::size_t>(1));
+
+       #if JUCE_WINDOWS
+        return alignment != 0 ? _aligned_malloc(size, alignment) : std::malloc(size);
+       #else
+        if (alignment == 0)
+            return SONDYCOMP_RT_RAW(malloc)(size);
+
+        void* memory = nullptr;
+        return SONDYCOMP_RT_RAW(posix_memalign)(&memory, juce::jmax(alignment, sizeof(void*)), size) == 0 ? memory : nullptr;
+       #endif
+    }
+
+    void* allocateOrThrow(std::size_t size, std::size_t alignment)
+    {
+        if (auto* memory = allocate(size, alignment))
+            return memory;
+
+        throw std::bad_alloc();
+    }
+
+    void deallocate(void* memory, bool isAligned) noexcept
+    {
+        if (memory == nullptr)
+            return;
+
+        record(Kind::deallocation, "operator delete");
+
+       #if JUCE_WINDOWS
+        if (isAligned)
+            _aligned_free(memory);
+        else
+            std::free(memory);
+       #else
+        juce::ignoreUnused(isAligned);
+        SONDYCOMP_RT_RAW(free)(memory);
+       #endif
+    }
+}
+
+//==============================================================================
+RealtimeChecks::ScopedAudioCallback::ScopedAudioCallback() noexcept
+{
+    ++callbackDepth;
+}
+
+RealtimeChecks::ScopedAudioCallback::~ScopedAudioCallback() noexcept
+{
+    --callbackDepth;
+}
+
+RealtimeChecks::Reporter::Reporter()
+{
+    const std::lock_guard<std::mutex> lock(reporterLock);
+
+    if (numReporters++ > 0)
+        return;
+
+    // The first stack capture loads the unwinder, which allocates; get that
+    // done here rather than in the audio callback
+    void* frames[maxFrames];
+    captureStack(frames);
+
+    abortOnViolation = juce::SystemStats::getEnvironmentVariable("SONDYCOMP_RT_CHECKS", {}) == "abort";
+    reportThread = std::make_unique<ReportThread>();
+    reportThread->startThread();
+
+    juce::Logger::writeToLog(juce::String("Realtime checks enabled") + (abortOnViolation ? ", aborting on the first violation" : ""));
+}
+
+RealtimeChecks::Reporter::~Reporter()
+{
+    const std::lock_guard<std::mutex> lock(reporterLock);
+
+    if (--numReporters == 0)
+        reportThread.reset();
+}
+
+int RealtimeChecks::getNumViolations() noexcept
+{
+    return numViolations.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+// Replacements for every global operator new and delete in this binary
+void* operator new(std::size_t size)                                                       { return allocateOrThrow(size, 0); }
+void* operator new[](std::size_t size)                                                     { return allocateOrThrow(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept                       { return allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept                     { return allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment)                           { return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment)                         { return allocateOrThrow(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept   { return allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* memory) noexcept                                                { deallocate(memory, false); }
+void operator delete[](void* memory) noexcept                                              { deallocate(memory, false); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept                         { deallocate(memory, false); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept                       { deallocate(memory, false); }
+void operator delete(void* memory, std::size_t) noexcept                                   { deallocate(memory, false); }
+void operator delete[](void* memory, std::size_t) noexcept                                 { deallocate(memory, false); }
+void operator delete(void* memory, std::align_val_t) noexcept                              { deallocate(memory, true); }
+void operator delete[](void* memory, std::align_val_t) noexcept                            { deallocate(memory, true); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept                 { deallocate(memory, true); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept               { deallocate(memory, true); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept       { deallocate(memory, true); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept     { deallocate(memory, true); }
+
+//==============================================================================
+// Link-time wrappers, enabled by the --wrap linker options CMakeLists.txt adds
+// on Linux. Each records the call and forwards to the real function
+#if JUCE_LINUX
+#define SONDYCOMP_RT_WRAP(kind, result, function, parameters, arguments) \
+    result __real_##function parameters; \
+    result __wrap_##function parameters { record(kind, #function); return __real_##function arguments; }
+
+extern "C"
+{
+    SONDYCOMP_RT_WRAP(Kind::allocation, void*, malloc, (size_t size), (size))
+    SONDYCOMP_RT_WRAP(Kind::allocation, void*, calloc, (size_t count, size_t size), (count, size))
+    SONDYCOMP_RT_WRAP(Kind::allocation, void*, realloc, (void* memory, size_t size), (memory, size))
+    SONDYCOMP_RT_WRAP(Kind::allocation, int, posix_memalign, (void** memory, size_t alignment, size_t size), (memory, alignment, size))
+    SONDYCOMP_RT_WRAP(Kind::allocation, void*, aligned_alloc, (size_t alignment, size_t size), (alignment, size))
+
+    SONDYCOMP_RT_WRAP(Kind::mutexLock, int, pthread_mutex_lock, (pthread_mutex_t* mutex), (mutex))
+    SONDYCOMP_RT_WRAP(Kind::mutexLock, int, pthread_rwlock_rdlock, (pthread_rwlock_t* lock), (lock))
+    SONDYCOMP_RT_WRAP(Kind::mutexLock, int, pthread_rwlock_wrlock, (pthread_rwlock_t* lock), (lock))
+    SONDYCOMP_RT_WRAP(Kind::mutexLock, int, pthread_cond_wait, (pthread_cond_t* condition, pthread_mutex_t* mutex), (condition, mutex))
+    SONDYCOMP_RT_WRAP(Kind::mutexLock, int, pthread_cond_timedwait, (pthread_cond_t* condition, pthread_mutex_t* mutex, const timespec* time), (condition, mutex, time))
+    SONDYCOMP_RT_WRAP(Kind::mutexLock, int, sem_wait, (sem_t* semaphore), (semaphore))
+
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, ssize_t, read, (int file, void* data, size_t size), (file, data, size))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, ssize_t, write, (int file, const void* data, size_t size), (file, data, size))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, FILE*, fopen, (const char* path, const char* mode), (path, mode))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, FILE*, fopen64, (const char* path, const char* mode), (path, mode))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, size_t, fread, (void* data, size_t size, size_t count, FILE* file), (data, size, count, file))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, size_t, fwrite, (const void* data, size_t size, size_t count, FILE* file), (data, size, count, file))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, int, nanosleep, (const timespec* duration, timespec* remaining), (duration, remaining))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, int, usleep, (useconds_t microseconds), (microseconds))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, unsigned int, sleep, (unsigned int seconds), (seconds))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, int, poll, (pollfd* files, nfds_t numFiles, int timeout), (files, numFiles, timeout))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, int, select, (int numFiles, fd_set* readFiles, fd_set* writeFiles, fd_set* errorFiles, timeval* timeout), (numFiles, readFiles, writeFiles, errorFiles, timeout))
+    SONDYCOMP_RT_WRAP(Kind::blockingCall, int, pthread_join, (pthread_t thread, void** result), (thread, result))
+
+    void __wrap_free(void* memory)
+    {
+        if (memory != nullptr)
+            record(Kind::deallocation, "free");
+
+        __real_free(memory);
+    }
+
+    // open() takes a mode only when it creates the file
+    int __real_open(const char* path, int flags, ...);
+    int __real_open64(const char* path, int flags, ...);
+
+    int __wrap_open(const char* path, int flags, ...)
+    {
+        record(Kind::blockingCall, "open");
+
+        va_list arguments;
+        va_start(arguments, flags);
+        const auto mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg(arguments, mode_t) : mode_t();
+        va_end(arguments);
+
+        return __real_open(path, flags, mode);
+    }
+
+    int __wrap_open64(const char* path, int flags, ...)
+    {
+        record(Kind::blockingCall, "open64");
+
+        va_list arguments;
+        va_start(arguments, flags);
+        const auto mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg(arguments, mode_t) : mode_t();
+        va_end(arguments);
+
+        return __real_open64(path, flags, mode);
+    }
+}
+
+#undef SONDYCOMP_RT_WRAP
+#endif
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+// Realtime-safety instrumentation for the audio callback, built in with
+// SONDYCOMP_RT_CHECKS. While a ScopedAudioCallback is alive on a thread, heap
+// allocations and frees, mutex locks and blocking system calls made on that
+// thread are recorded with a stack trace, and a Reporter writes them to the
+// log from a background thread.
+//
+// operator new and delete are hooked everywhere. On Linux the malloc family,
+// pthread locks and blocking calls such as read, write and nanosleep are
+// hooked as well, by wrapping the symbols at link time.
+//
+// Set SONDYCOMP_RT_CHECKS=abort in the environment to abort on the first
+// violation instead, which makes a host or validator run fail.
+//
+// Without SONDYCOMP_RT_CHECKS everything here compiles to nothing.
+namespace RealtimeChecks
+{
+    enum class Kind
+    {
+        allocation,
+        deallocation,
+        mutexLock,
+        blockingCall
+    };
+
+    const char* getName(Kind kind);
+
+   #if SONDYCOMP_RT_CHECKS
+    // Marks the current thread as inside the audio callback for its lifetime.
+    // Scopes nest
+    class ScopedAudioCallback
+    {
+    public:
+        ScopedAudioCallback() noexcept;
+        ~ScopedAudioCallback() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioCallback)
+    };
+
+    // Violations are logged while at least one Reporter exists; the plugin
+    // processor holds one
+    class Reporter
+    {
+    public:
+        Reporter();
+        ~Reporter();
+
+        JUCE_DECLARE_NON_COPYABLE(Reporter)
+    };
+
+    // Violations recorded since the library was loaded, in every instance
+    int getNumViolations() noexcept;
+   #else
+    class ScopedAudioCallback
+    {
+    public:
+        ScopedAudioCallback() noexcept {}
+    };
+
+    class Reporter
+    {
+    public:
+        Reporter() {}
+    };
+
+    inline int getNumViolations() noexcept { return 0; }
+   #endif
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+// Windowed RMS of a level signal, computed with a running sum of squares.
+//
+// Each block is done in vector passes: square the levels, fetch the squares
+// that leave the window from a ring buffer, and subtract to get the change in
+// the sum per sample. Only the prefix sum of those changes is serial (one add
+// per sample). The running sum is recomputed from the ring every so often so
+// rounding errors cannot accumulate.
+class RmsDetector
+{
+public:
+    // Allocate for windows up to maxWindowLength and blocks up to maxBlockSize
+    void prepare(int maxWindowLength, int maxBlockSize)
+    {
+        maxLength = juce::jmax(1, maxWindowLength);
+        ringSize = maxLength + juce::jmax(1, maxBlockSize);
+        ring.assign(static_cast<size_t>(ringSize), 0.0f);
+        squares.assign(static_cast<size_t>(juce::jmax(1, maxBlockSize)), 0.0f);
+        leaving.assign(static_cast<size_t>(juce::jmax(1, maxBlockSize)), 0.0f);
+        windowLength = juce::jmin(windowLength, maxLength);
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(ring.begin(), ring.end(), 0.0f);
+        writePosition = 0;
+        runningSum = 0.0;
+        samplesSinceCorrection = 0;
+    }
+
+    // The ring keeps enough history to resum any window up to the maximum,
+    // so the new window is exact from the next sample on
+    void setWindowLength(int newWindowLength)
+    {
+        windowLength = juce::jlimit(1, maxLength, newWindowLength);
+        resum();
+    }
+
+    int getWindowLength() const { return windowLength; }
+
+    // rms[i] = sqrt(mean of levels^2 over the last windowLength samples)
+    void process(const float* levels, float* rms, int numSamples)
+    {
+        jassert(numSamples <= static_cast<int>(squares.size()));
+
+        // Squares entering the window, and the ones leaving it
+        juce::FloatVectorOperations::multiply(squares.data(), levels, levels, numSamples);
+        copyIntoRing(writePosition, squares.data(), numSamples);
+        copyFromRing(leaving.data(), (writePosition - windowLength + ringSize) % ringSize, numSamples);
+        juce::FloatVectorOperations::subtract(leaving.data(), squares.data(), leaving.data(), numSamples);
+        writePosition = (writePosition + numSamples) % ringSize;
+
+        // Prefix sum of the per-sample change (the only serial part)
+        const auto* delta = leaving.data();
+        for (int i = 0; i < numSamples; ++i)
+        {
+            runningSum += delta[i];
+            rms[i] = static_cast<float>(runningSum);
+        }
+
+        // Mean square -> RMS; clamp tiny negative sums left by rounding
+        juce::FloatVectorOperations::max(rms, rms, 0.0f, numSamples);
+        juce::FloatVectorOperations::multiply(rms, 1.0f / static_cast<float>(windowLength), numSamples);
+        for (int i = 0; i < numSamples; ++i)
+            rms[i] = std::sqrt(rms[i]);
+
+        // Periodic drift correction
+        samplesSinceCorrection += numSamples;
+        if (samplesSinceCorrection >= juce::jmax(windowLength, correctionInterval))
+            resum();
+    }
+
+private:
+    static constexpr int correctionInterval = 1 << 16;
+
+    // Recompute the running sum exactly from the last windowLength squares
+    void resum()
+    {
+        double sum = 0.0;
+        for (int i = 1; i <= windowLength; ++i)
+            sum += ring[static_cast<size_t>((writePosition - i + ringSize) % ringSize)];
+
+        runningSum = sum;
+        samplesSinceCorrection = 0;
+    }
+
+    void copyIntoRing(int position, const float* source, int numSamples)
+    {
+        const int firstPart = juce::jmin(numSamples, ringSize - position);
+        juce::FloatVectorOperations::copy(ring.data() + position, source, firstPart);
+        juce::FloatVectorOperations::copy(ring.data(), source + firstPart, numSamples - firstPart);
+    }
+
+    void copyFromRing(float* dest, int position, int numSamples) const
+    {
+        const int firstPart = juce::jmin(numSamples, ringSize - position);
+        juce::FloatVectorOperations::copy(dest, ring.data() + position, firstPart);
+        juce::FloatVectorOperations::copy(dest + firstPart, ring.data(), numSamples - firstPart);
+    }
+
+    std::vector<float> ring;
+    std::vector<float> squares;
+    std::vector<float> leaving;
+    int ringSize = 1;
+    int maxLength = 1;
+    int windowLength = 1;
+    int writePosition = 0;
+    int samplesSinceCorrection = 0;
+    double runningSum = 0.0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+//==============================================================================
+// Running maximum over the last N samples, for the lookahead detector.
+//
+// A monotonic deque: values that can never be the window maximum again (those
+// followed by a larger value) are dropped as soon as they are seen, so every
+// sample is pushed and popped at most once. The cost per sample is O(1)
+// amortized regardless of the window length.
+class SlidingWindowMax
+{
+public:
+    // Allocate for windows of up to maxWindowLength samples
+    void prepare(int maxWindowLength)
+    {
+        maxLength = juce::jmax(1, maxWindowLength);
+
+        // Power-of-two ring, so wrapping is a mask
+        const int capacity = juce::nextPowerOfTwo(maxLength + 1);
+        mask = capacity - 1;
+        values.assign(static_cast<size_t>(capacity), 0.0f);
+        positions.assign(static_cast<size_t>(capacity), 0);
+        windowLength = juce::jmin(windowLength, maxLength);
+        reset();
+    }
+
+    void reset()
+    {
+        head = 0;
+        size = 0;
+        position = 0;
+    }
+
+    // Takes effect immediately; samples already in the deque are kept
+    void setWindowLength(int newWindowLength)
+    {
+        windowLength = juce::jlimit(1, maxLength, newWindowLength);
+    }
+
+    int getWindowLength() const { return windowLength; }
+
+    // Replace each sample with the maximum of itself and the previous
+    // windowLength - 1 samples. Safe in place
+    void process(float* dest, const float* source, int numSamples)
+    {
+        if (windowLength <= 1)
+        {
+            if (dest != source)
+                juce::FloatVectorOperations::copy(dest, source, numSamples);
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float value = source[i];
+
+            // Drop smaller values from the back; they can never be the maximum again
+            while (size > 0 && values[static_cast<size_t>(indexAt(size - 1))] <= value)
+                --size;
+
+            const auto back = static_cast<size_t>(indexAt(size));
+            values[back] = value;
+            positions[back] = position;
+            ++size;
+
+            // Drop the front once it has slid out of the window
+            while (positions[static_cast<size_t>(head)] <= position - windowLength)
+            {
+                head = (head + 1) & mask;
+                --size;
+            }
+
+            dest[i] = values[static_cast<size_t>(head)];
+            ++position;
+        }
+    }
+
+private:
+    int indexAt(int offset) const { return (head + offset) & mask; }
+
+    std::vector<float> values;
+    std::vector<juce::int64> positions;
+    int maxLength = 1;
+    int mask = 0;
+    int head = 0;
+    int size = 0;
+    int windowLength = 1;
+    juce::int64 position = 0;
+};
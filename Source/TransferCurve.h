@@ -0,0 +1,115 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+
+//==============================================================================
+// The compressor's static curve (input level in dB -> gain reduction in dB),
+// compiled into a piecewise polynomial whenever threshold, knee or ratio change.
+//
+// The curve has three pieces: nothing below the knee, a cubic across the knee
+// and a straight line above it. Clamping the input into the knee and adding
+// the linear part above it evaluates all three without branches:
+//
+//     x  = clamp(level, kneeStart, kneeEnd)
+//     gr = (x - kneeStart)^2 * (x - threshold) * slope / knee^2
+//        + max(level - kneeEnd, 0) * slope
+//
+// compile() also picks one of three specialized gain computers, so the block
+// loop for the common hard-knee case carries no knee math at all:
+//   hardKnee  knee == 0:                gr = max(level - threshold, 0) * slope
+//   limiter   knee == 0, ratio == inf:  gr = max(level - threshold, 0)
+//   softKnee  knee > 0, any ratio:      the full form above
+class TransferCurve
+{
+public:
+    enum class GainComputer
+    {
+        hardKnee,
+        softKnee,
+        limiter
+    };
+
+    TransferCurve() { compile(0.0f, 0.0f, 4.0f); }
+
+    // Rebuild the coefficients; cheap, but only needed when a parameter changes.
+    // A ratio of std::numeric_limits<float>::infinity() gives a limiter
+    void compile(float newThreshold, float newKnee, float newRatio)
+    {
+        threshold = newThreshold;
+        kneeStart = newThreshold - newKnee / 2.0f;
+        kneeEnd = newThreshold + newKnee / 2.0f;
+        slope = 1.0f - 1.0f / newRatio;
+        kneeScale = newKnee > 0.0f ? slope / (newKnee * newKnee) : 0.0f;
+
+        if (newKnee > 0.0f)
+            gainComputer = GainComputer::softKnee;
+        else if (std::isinf(newRatio))
+            gainComputer = GainComputer::limiter;
+        else
+            gainComputer = GainComputer::hardKnee;
+    }
+
+    GainComputer getGainComputer() const { return gainComputer; }
+
+    // Gain reduction in dB for an input level in dB
+    template <GainComputer type>
+    float evaluate(float inputLevelDB) const
+    {
+        if constexpr (type == GainComputer::limiter)
+        {
+            return juce::jmax(inputLevelDB - threshold, 0.0f);
+        }
+        else if constexpr (type == GainComputer::hardKnee)
+        {
+            return juce::jmax(inputLevelDB - threshold, 0.0f) * slope;
+        }
+        else
+        {
+            const float x = juce::jlimit(kneeStart, kneeEnd, inputLevelDB);
+            const float fromKneeStart = x - kneeStart;
+            const float kneePart = fromKneeStart * fromKneeStart * (x - threshold) * kneeScale;
+            const float linearPart = juce::jmax(inputLevelDB - kneeEnd, 0.0f) * slope;
+            return kneePart + linearPart;
+        }
+    }
+
+    float evaluate(float inputLevelDB) const
+    {
+        switch (gainComputer)
+        {
+            case GainComputer::hardKnee: return evaluate<GainComputer::hardKnee>(inputLevelDB);
+            case GainComputer::limiter:  return evaluate<GainComputer::limiter>(inputLevelDB);
+            case GainComputer::softKnee: break;
+        }
+
+        return evaluate<GainComputer::softKnee>(inputLevelDB);
+    }
+
+    // Block version, safe to use in place (dest == source).
+    // The gain computer is chosen once here, not per sample
+    void evaluate(float* dest, const float* source, int numSamples) const
+    {
+        switch (gainComputer)
+        {
+            case GainComputer::hardKnee: evaluateBlock<GainComputer::hardKnee>(dest, source, numSamples); break;
+            case GainComputer::limiter:  evaluateBlock<GainComputer::limiter>(dest, source, numSamples); break;
+            case GainComputer::softKnee: evaluateBlock<GainComputer::softKnee>(dest, source, numSamples); break;
+        }
+    }
+
+private:
+    template <GainComputer type>
+    void evaluateBlock(float* dest, const float* source, int numSamples) const
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = evaluate<type>(source[i]);
+    }
+
+    float threshold = 0.0f;
+    float kneeStart = 0.0f;
+    float kneeEnd = 0.0f;
+    float slope = 0.0f;
+    float kneeScale = 0.0f;
+    GainComputer gainComputer = GainComputer::hardKnee;
+};
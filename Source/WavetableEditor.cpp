@@ -463,106 +463,6 @@ void WavetableEditor::presetButtonClicked(int curveType)
 // Apply a preset curve based on the selected type
 void WavetableEditor::applyPresetCurve(int curveType)
 {
-    switch (curveType)
-    {
-        case 0: applyLinearCurve(); break;
-        case 1: applyExponentialCurve(); break;
-        case 2: applyLogarithmicCurve(); break;
-        case 3: applySCurve(); break;
-    }
-}
-
-// Linear curve: straight line from start to end
-void WavetableEditor::applyLinearCurve()
-{
-    // For attack mode: 0 to 1
-    // For release mode: 1 to 0
-    const float startValue = isReleaseMode ? 1.0f : 0.0f;
-    const float endValue = isReleaseMode ? 0.0f : 1.0f;
-    
-    for (size_t i = 0; i < wavetable.size(); ++i)
-    {
-        float normalizedPos = static_cast<float>(i) / static_cast<float>(wavetable.size() - 1);
-        wavetable[i] = startValue + normalizedPos * (endValue - startValue);
-    }
-}
-
-// Exponential curve: starts slow, accelerates
-void WavetableEditor::applyExponentialCurve()
-{
-    const float startValue = isReleaseMode ? 1.0f : 0.0f;
-    const float endValue = isReleaseMode ? 0.0f : 1.0f;
-    const float range = endValue - startValue;
-    
-    for (size_t i = 0; i < wavetable.size(); ++i)
-    {
-        float normalizedPos = static_cast<float>(i) / static_cast<float>(wavetable.size() - 1);
-        float curveValue;
-        
-        if (isReleaseMode)
-        {
-            // For release: 1 - x^2 gives slower initial decrease
-            curveValue = 1.0f - std::pow(normalizedPos, 2.0f);
-        }
-        else
-        {
-            // For attack: x^2 gives slower initial increase
-            curveValue = std::pow(normalizedPos, 2.0f);
-        }
-        
-        wavetable[i] = startValue + curveValue * range;
-    }
-}
-
-// Logarithmic curve: starts fast, slows down
-void WavetableEditor::applyLogarithmicCurve()
-{
-    const float startValue = isReleaseMode ? 1.0f : 0.0f;
-    const float endValue = isReleaseMode ? 0.0f : 1.0f;
-    const float range = endValue - startValue;
-    
-    for (size_t i = 0; i < wavetable.size(); ++i)
-    {
-        float normalizedPos = static_cast<float>(i) / static_cast<float>(wavetable.size() - 1);
-        float curveValue;
-        
-        if (isReleaseMode)
-        {
-            // For release: sqrt(1-x) gives faster initial decrease
-            curveValue = std::sqrt(1.0f - normalizedPos);
-        }
-        else
-        {
-            // For attack: sqrt(x) gives faster initial increase
-            curveValue = std::sqrt(normalizedPos);
-        }
-        
-        wavetable[i] = startValue + curveValue * range;
-    }
-}
-
-// S-Curve: smooth transition with sigmoid shape
-void WavetableEditor::applySCurve()
-{
-    const float startValue = isReleaseMode ? 1.0f : 0.0f;
-    const float endValue = isReleaseMode ? 0.0f : 1.0f;
-    const float range = endValue - startValue;
-    
-    for (size_t i = 0; i < wavetable.size(); ++i)
-    {
-        float normalizedPos = static_cast<float>(i) / static_cast<float>(wavetable.size() - 1);
-        float curveValue;
-        
-        // Sigmoid function: 1/(1+e^(-k*(x-0.5)))
-        const float k = 10.0f; // Steepness of S-curve
-        curveValue = 1.0f / (1.0f + std::exp(-k * (normalizedPos - 0.5f)));
-        
-        if (isReleaseMode)
-        {
-            // For release: invert the curve
-            curveValue = 1.0f - curveValue;
-        }
-        
-        wavetable[i] = startValue + curveValue * range;
-    }
-} 
\ No newline at end of file
+    if (juce::isPositiveAndBelow(curveType, CurvePresets::numShapes))
+        wavetable = CurvePresets::make(static_cast<CurvePresets::Shape>(curveType), isReleaseMode);
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <array>
 #include <functional>
+#include "CurvePresets.h"
 
 //==============================================================================
 class WavetablePresetButton : public juce::Button
@@ -59,10 +60,6 @@ private:
     
     // Apply preset curves
     void applyPresetCurve(int curveType);
-    void applyLinearCurve();
-    void applyExponentialCurve();
-    void applyLogarithmicCurve();
-    void applySCurve();
     
     // Callback for preset buttons
     void presetButtonClicked(int curveType);
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+// Wait-free hand-off of a table from the message thread to the audio thread.
+//
+// A triple buffer: the writer fills its private back slot and swaps it into
+// the shared middle slot; the audio thread swaps the middle slot into its
+// private front slot at a block boundary. Neither side ever waits, locks or
+// allocates, and the audio thread only ever sees complete tables.
+template <typename TableType>
+class WavetableExchange
+{
+public:
+    WavetableExchange() = default;
+
+    // Fill every slot with the same table. Not thread-safe: only call this
+    // before audio processing starts
+    void reset(const TableType& table)
+    {
+        for (auto& slot : slots)
+            slot = table;
+
+        latest = table;
+        backIndex = 0;
+        frontIndex = 1;
+        middleState.store(2, std::memory_order_release);
+    }
+
+    // Message thread: publish a new table for the audio thread to pick up
+    void publish(const TableType& table)
+    {
+        latest = table;
+        slots[backIndex] = table;
+
+        const int previousMiddle = middleState.exchange(backIndex | dirtyFlag, std::memory_order_acq_rel);
+        backIndex = previousMiddle & indexMask;
+    }
+
+    // Message thread: the most recently published table
+    const TableType& getLatest() const { return latest; }
+
+    // Audio thread: pick up a newly published table, if there is one.
+    // Call once at the start of a block; returns true if the table changed
+    bool acquireLatest()
+    {
+        if ((middleState.load(std::memory_order_relaxed) & dirtyFlag) == 0)
+            return false;
+
+        const int previousMiddle = middleState.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previousMiddle & indexMask;
+        swapCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Audio thread: the table in use for the current block
+    const TableType& getCurrent() const { return slots[frontIndex]; }
+
+    // Total number of tables the audio thread has picked up
+    juce::uint32 getNumSwaps() const { return swapCount.load(std::memory_order_relaxed); }
+
+    // Message thread: swaps per second since the previous call
+    double getSwapsPerSecond()
+    {
+        const auto now = juce::Time::getMillisecondCounterHiRes();
+        const auto count = getNumSwaps();
+        const auto elapsedSeconds = (now - lastRateQueryTime) * 0.001;
+
+        double rate = 0.0;
+        if (lastRateQueryTime > 0.0 && elapsedSeconds > 0.0)
+            rate = static_cast<double>(count - lastRateQueryCount) / elapsedSeconds;
+
+        lastRateQueryTime = now;
+        lastRateQueryCount = count;
+        return rate;
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int dirtyFlag = 4;
+
+    std::array<TableType, 3> slots {};
+
+    // Writer-owned
+    int backIndex = 0;
+    TableType latest {};
+
+    // Shared: index of the middle slot, plus dirtyFlag while it holds an unread table
+    std::atomic<int> middleState { 2 };
+
+    // Reader-owned
+    int frontIndex = 1;
+    std::atomic<juce::uint32> swapCount { 0 };
+
+    // Diagnostics, message thread only
+    double lastRateQueryTime = 0.0;
+    juce::uint32 lastRateQueryCount = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(WavetableExchange)
+};